@@ -0,0 +1,40 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+// Measures the soft float libcalls with the simulator's cycle counter. The
+// operands are volatile so that nothing is folded at compile time.
+
+#define REPS 16
+
+static volatile float a = 1234.5678f, b = -0.0421f, r;
+static volatile long l = 123456;
+static volatile long lr;
+static volatile int cr;
+
+static unsigned long overhead;
+
+#define MEASURE(name, expr)                                                    \
+  do {                                                                         \
+    reset_clock();                                                             \
+    for (char i = 0; i < REPS; ++i)                                            \
+      expr;                                                                    \
+    unsigned long cycles = clock();                                            \
+    printf("%-8s %5lu CYCLES\n", name, (cycles - overhead) / REPS);            \
+  } while (0)
+
+int main(void) {
+  reset_clock();
+  for (char i = 0; i < REPS; ++i)
+    r = a;
+  overhead = clock();
+
+  MEASURE("ADD", r = a + b);
+  MEASURE("SUB", r = a - b);
+  MEASURE("MUL", r = a * b);
+  MEASURE("DIV", r = a / b);
+  MEASURE("LT", cr = a < b);
+  MEASURE("EQ", cr = a == b);
+  MEASURE("FROMINT", r = l);
+  MEASURE("TOINT", lr = a);
+  return 0;
+}
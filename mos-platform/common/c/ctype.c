@@ -1,6 +1,44 @@
 #include <ctype.h>
 
-int isprint(int c) {
-  char ch = (char)c;
-  return ch >= 0x1f && ch < 0x7f /*DEL*/;
-}
+#define U __CTYPE_UPPER
+#define L __CTYPE_LOWER
+#define D __CTYPE_DIGIT
+#define S __CTYPE_SPACE
+#define P __CTYPE_PUNCT
+#define C __CTYPE_CNTRL
+#define X __CTYPE_HEX
+#define B __CTYPE_BLANK
+
+const unsigned char __ctype[256] = {
+    [0 ... '\t' - 1] = C,
+    ['\t' ... '\r'] = C | S,
+    ['\r' + 1 ... 0x1f] = C,
+    [' '] = S | B,
+    ['!' ... '/'] = P,
+    ['0' ... '9'] = D,
+    [':' ... '@'] = P,
+    ['A' ... 'F'] = U | X,
+    ['G' ... 'Z'] = U,
+    ['[' ... '`'] = P,
+    ['a' ... 'f'] = L | X,
+    ['g' ... 'z'] = L,
+    ['{' ... '~'] = P,
+    [0x7f] = C,
+};
+
+// Define the functions in terms of the macros.
+int(isalnum)(int c) { return isalnum(c); }
+int(isalpha)(int c) { return isalpha(c); }
+int(isblank)(int c) { return c == '\t' || __ctype_is(c, B); }
+int(iscntrl)(int c) { return iscntrl(c); }
+int(isdigit)(int c) { return isdigit(c); }
+int(isgraph)(int c) { return isgraph(c); }
+int(islower)(int c) { return islower(c); }
+int(isprint)(int c) { return isprint(c); }
+int(ispunct)(int c) { return ispunct(c); }
+int(isspace)(int c) { return isspace(c); }
+int(isupper)(int c) { return isupper(c); }
+int(isxdigit)(int c) { return isxdigit(c); }
+
+int tolower(int c) { return isupper(c) ? c + ('a' - 'A') : c; }
+int toupper(int c) { return islower(c) ? c - ('a' - 'A') : c; }
@@ -12,7 +12,12 @@ struct ExitFunctionStorage {
 
 /* Exit functions are registered in a singly-linked list of blocks of
  * registrations. Each block contains 32 exit registrations, and additional
- * space for registrations is allocated on the heap, as needed.*/
+ * space for registrations is allocated on the heap, as needed.
+ *
+ * The first block is static, but lives in .noinit so that it costs nothing
+ * at startup; it is set up by the first registration instead. The compiler
+ * registers global destructors at run time, so they can't be collected into a
+ * table at link time; destructor attributes already are (.fini_array).*/
 class RegistrationList {
 private:
   // FnBlock is an array of function pointers and their arguments.
@@ -44,6 +49,10 @@ private:
 
 public:
   static bool push_front(const ExitFunctionStorage &new_exit) {
+    if (!m_list) {
+      m_tail.m_sz = 0;
+      m_list = &m_tail;
+    }
 
     auto &current_block = *m_list;
 
@@ -65,18 +74,21 @@ public:
   }
 
   static void run_all_exits() {
-    while (m_list != &m_tail || !m_list->empty()) {
-      if (!m_list->empty()) {
-        // Note: fn may itself call atexit, so pop first.
+    // Nothing was ever registered, so m_tail was never set up.
+    if (!m_list)
+      return;
+    for (;;) {
+      // Note: fn may itself call atexit, which may even push a new block, so
+      // pop first and reload m_list each time.
+      while (!m_list->empty()) {
         ExitFunctionStorage fn = m_list->back();
         m_list->pop_back();
         fn();
-      } else {
-        const auto current_node_ptr = static_cast<FnNode *>(m_list);
-        const auto next_block = current_node_ptr->m_next;
-        // current_node_ptr is leaked here. We are shutting down.
-        m_list = next_block;
       }
+      if (m_list == &m_tail)
+        return;
+      // The node is leaked here. We are shutting down.
+      m_list = static_cast<FnNode *>(m_list)->m_next;
     }
   }
 
@@ -85,12 +97,14 @@ private:
   // of exit functions, without allocating.  So the minumum required
   // 32 exit functions will always be available.
   static FnBlock m_tail;
+  // Null until the first registration.
   static FnBlock *m_list;
 };
 
 // Static allocation of registration list.
-RegistrationList::FnBlock RegistrationList::m_tail{};
-RegistrationList::FnBlock *RegistrationList::m_list = &m_tail;
+__attribute__((section(".noinit"))) RegistrationList::FnBlock
+    RegistrationList::m_tail;
+RegistrationList::FnBlock *RegistrationList::m_list;
 
 } // namespace
 
@@ -0,0 +1,160 @@
+#include <stdlib.h>
+
+#include <stdbool.h>
+#include <string.h>
+
+static void _bcd_shl(char *bcd, char *bcd_size, char base) {
+  bool carry = false;
+  for (char i = 0, e = *bcd_size; i < e; ++i) {
+    bcd[i] <<= 1;
+    if (carry)
+      ++bcd[i];
+    carry = bcd[i] >= base;
+    if (carry)
+      bcd[i] -= base;
+  }
+  if (carry)
+    bcd[(*bcd_size)++] = 1;
+}
+
+static void _bcd_inc(char *bcd, char *bcd_size, char base) {
+  bool carry = true;
+  for (char i = 0, e = *bcd_size; i < e; ++i) {
+    if (!carry)
+      return;
+    ++bcd[i];
+    carry = bcd[i] == base;
+    if (carry)
+      bcd[i] = 0;
+  }
+  if (carry)
+    bcd[(*bcd_size)++] = 1;
+}
+
+static void _bin_shl(unsigned char *value, char value_size) {
+  bool carry = false;
+  for (char i = 0; i < value_size; ++i) {
+    bool new_carry = value[i] & 0x80;
+    value[i] = value[i] << 1 | carry;
+    carry = new_carry;
+  }
+}
+
+static void _bin_shr(unsigned char *value, char value_size) {
+  bool carry = false;
+  for (char i = value_size; i--;) {
+    bool new_carry = value[i] & 1;
+    value[i] = value[i] >> 1 | carry << 7;
+    carry = new_carry;
+  }
+}
+
+// Writes the digits of the little-endian unsigned integer at value, least
+// significant first, as ASCII in the given base (2 to 36). Returns the number
+// of digits, which is at least one. Shared with printf.
+char __utoa_rev(char *buf, const char *value, char value_size, char base,
+                bool uppercase) {
+  // Unsigned, so that shifting right never sign-extends.
+  unsigned char working_value[sizeof(long long)];
+
+  // Leading zero bytes add nothing but work.
+  while (value_size && !value[value_size - 1])
+    --value_size;
+  if (!value_size) {
+    buf[0] = '0';
+    return 1;
+  }
+  memcpy(working_value, value, value_size);
+
+  char len = 0;
+  char shift = 0;
+  while (1 << shift < base)
+    ++shift;
+  if (1 << shift == base) {
+    // Powers of two take each digit straight from the low bits.
+    const char mask = base - 1;
+    do {
+      buf[len++] = working_value[0] & mask;
+      for (char i = 0; i < shift; ++i)
+        _bin_shr(working_value, value_size);
+      while (value_size && !working_value[value_size - 1])
+        --value_size;
+    } while (value_size);
+  } else {
+    // Initially, the buffer contains BCD zero.
+    buf[len++] = 0;
+    // Handle the binary value from high bit to low.
+    for (char i = 0; i < value_size * 8; ++i) {
+      // Shift the BCD left.
+      _bcd_shl(buf, &len, base);
+      // Shift the binary value left, and if the high bit is set, increment
+      // the BCD to shift it in.
+      if (working_value[value_size - 1] & 0x80)
+        _bcd_inc(buf, &len, base);
+      _bin_shl(working_value, value_size);
+    }
+  }
+
+  // Convert from BCD to ASCII.
+  for (char i = 0; i < len; ++i) {
+    buf[i] = buf[i] < 10 ? '0' + buf[i] : (uppercase ? 'A' : 'a') + buf[i] - 10;
+  }
+  return len;
+}
+
+static char *_ntoa(char *str, const char *value, char value_size,
+                   bool negative, unsigned char width, int base) {
+  char *p = str;
+  if (base >= 2 && base <= 36) {
+    char buf[sizeof(long long) * 8];
+    char len = __utoa_rev(buf, value, value_size, base, false);
+    if (negative)
+      *p++ = '-';
+    for (; width > len; --width)
+      *p++ = '0';
+    while (len)
+      *p++ = buf[--len];
+  }
+  *p = '\0';
+  return str;
+}
+
+// Only base 10 gets a sign; other bases show the two's complement bits.
+char *__itoa_pad(int value, char *str, unsigned char width, int base) {
+  bool negative = base == 10 && value < 0;
+  unsigned abs_value = negative ? 0U - value : value;
+  return _ntoa(str, (const char *)&abs_value, sizeof(abs_value), negative,
+               width, base);
+}
+
+char *__utoa_pad(unsigned value, char *str, unsigned char width, int base) {
+  return _ntoa(str, (const char *)&value, sizeof(value), false, width, base);
+}
+
+char *__ltoa_pad(long value, char *str, unsigned char width, int base) {
+  bool negative = base == 10 && value < 0;
+  unsigned long abs_value = negative ? 0UL - value : value;
+  return _ntoa(str, (const char *)&abs_value, sizeof(abs_value), negative,
+               width, base);
+}
+
+char *__ultoa_pad(unsigned long value, char *str, unsigned char width,
+                  int base) {
+  return _ntoa(str, (const char *)&value, sizeof(value), false, width, base);
+}
+
+char *itoa(int value, char *str, int base) {
+  return __itoa_pad(value, str, 0, base);
+}
+
+char *utoa(unsigned value, char *str, int base) {
+  return __utoa_pad(value, str, 0, base);
+}
+
+char *ltoa(long value, char *str, int base) {
+  return __ltoa_pad(value, str, 0, base);
+}
+
+char *ultoa(unsigned long value, char *str, int base) {
+  return __ultoa_pad(value, str, 0, base);
+}
@@ -196,7 +196,8 @@ static inline bool _is_digit(char ch) { return (ch >= '0') && (ch <= '9'); }
 static unsigned int _atoi(const char **str) {
   unsigned int i = 0U;
   while (_is_digit(**str)) {
-    i = i * 10U + (unsigned int)(*((*str)++) - '0');
+    // Multiply by 10 with shifts rather than a libcall.
+    i = ((i << 2) + i) * 2U + (unsigned int)(*((*str)++) - '0');
   }
   return i;
 }
@@ -292,86 +293,25 @@ static bool _is_zero(char *value, char value_size) {
   return true;
 }
 
-static bool _is_high_bit_set(char *value, char value_size) {
-  return value[value_size - 1] & 0x80;
-}
-
-static void _bcd_shl(char *bcd, char *bcd_size, char base) {
-  bool carry = false;
-  for (char i = 0, e = *bcd_size; i < e; ++i) {
-    bcd[i] <<= 1;
-    if (carry)
-      ++bcd[i];
-    carry = bcd[i] >= base;
-    if (carry)
-      bcd[i] -= base;
-  }
-  if (carry)
-    bcd[(*bcd_size)++] = 1;
-}
-
-static void _bcd_inc(char *bcd, char *bcd_size, char base) {
-  bool carry = true;
-  for (char i = 0, e = *bcd_size; i < e; ++i) {
-    if (!carry)
-      return;
-    ++bcd[i];
-    carry = bcd[i] == base;
-    if (carry)
-      bcd[i] = 0;
-  }
-  if (carry)
-    bcd[(*bcd_size)++] = 1;
-}
-
-static void _bin_shl(char *value, char value_size) {
-  bool carry = false;
-  for (char i = 0; i < value_size; ++i) {
-    bool new_carry = value[i] & 0x80;
-    value[i] = value[i] << 1 | carry;
-    carry = new_carry;
-  }
-}
+// Digits of an unsigned integer, least significant first (itoa.c).
+char __utoa_rev(char *buf, const char *value, char value_size, char base,
+                bool uppercase);
 
 static size_t _ntoa(out_fct_type out, char *buffer, size_t idx, size_t maxlen,
                     char *value, char value_size, bool negative,
                     unsigned long base, unsigned int prec, unsigned int width,
                     unsigned int flags) {
   char buf[PRINTF_NTOA_BUFFER_SIZE];
-  char working_value[sizeof(long long)];
   char len = 0U;
 
-  memcpy(working_value, value, value_size);
-
   // no hash for 0 values
-  bool is_zero = _is_zero(working_value, value_size);
+  bool is_zero = _is_zero(value, value_size);
   if (is_zero)
     flags &= ~FLAGS_HASH;
 
   // write if precision == 0 or value is != 0
-  if (!(flags & FLAGS_PRECISION) || !is_zero) {
-    // Initially, the buffer contains BCD zero.
-    buf[len++] = 0;
-    // Handle the binary value from high bit to low.
-    for (char i = 0; i < value_size * 8; ++i) {
-      // Shift the BCD left.
-      _bcd_shl(buf, &len, base);
-
-      // Shift the binary value left, and if the high bit is set, increment the
-      // BCD to shift it in.
-      if (_is_high_bit_set(working_value, value_size))
-        _bcd_inc(buf, &len, base);
-      _bin_shl(working_value, value_size);
-    }
-
-    // After the above, we've "shifted" the entire value out of binary and into
-    // BCD. Afterward, just convert from BCD to ASCII.
-    for (char i = 0; i < len; ++i) {
-      buf[i] = buf[i] < 10
-                   ? '0' + buf[i]
-                   : (flags & FLAGS_UPPERCASE ? 'A' : 'a') + buf[i] - 10;
-    }
-  }
+  if (!(flags & FLAGS_PRECISION) || !is_zero)
+    len = __utoa_rev(buf, value, value_size, base, flags & FLAGS_UPPERCASE);
 
   return _ntoa_format(out, buffer, idx, maxlen, buf, len, negative,
                       (unsigned int)base, prec, width, flags);
@@ -438,7 +378,8 @@ static size_t _ftoa(out_fct_type out, char *buffer, size_t idx, size_t maxlen,
     prec--;
   }
 
-  int whole = (int)value;
+  // int is only 16 bits, but whole parts run up to PRINTF_MAX_FLOAT.
+  unsigned long whole = (unsigned long)value;
   double tmp = (value - whole) * pow10[prec];
   unsigned long frac = (unsigned long)tmp;
   diff = tmp - frac;
@@ -485,8 +426,8 @@ static size_t _ftoa(out_fct_type out, char *buffer, size_t idx, size_t maxlen,
 
   // do whole part, number is reversed
   while (len < PRINTF_FTOA_BUFFER_SIZE) {
-    buf[len++] = (char)(48 + (whole % 10));
-    if (!(whole /= 10)) {
+    buf[len++] = (char)(48U + (whole % 10U));
+    if (!(whole /= 10U)) {
       break;
     }
   }
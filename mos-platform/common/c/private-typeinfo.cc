@@ -9,6 +9,7 @@
 #include "private-typeinfo.h"
 
 #include <cstddef>
+#include <cstdint>
 
 #include <string.h>
 
@@ -219,18 +220,106 @@ __class_type_info::process_found_base_class(__dynamic_cast_info* info,
 //    (static_ptr, static_type), then return dynamic_ptr.
 // Else return nullptr.
 
+// Results of recent casts, so that repeating a cast skips the search. A cast's
+// result depends only on the dynamic type, the static and destination types,
+// and which static_type subobject static_ptr points to; the last is given by
+// offset_to_derived. Each entry records where the result lies relative to
+// dynamic_ptr, or that the cast fails. Define DYNAMIC_CAST_CACHE_SIZE to 0 to
+// disable the cache, or to another power of two to resize it.
+//
+// Casts may run in interrupt handlers, so each entry carries a sequence number
+// that is odd while the entry is being written. A lookup that sees it odd, or
+// sees it change while reading the entry, ignores the entry and searches; a
+// write that finds it odd leaves the entry to the interrupted writer.
+#ifndef DYNAMIC_CAST_CACHE_SIZE
+#define DYNAMIC_CAST_CACHE_SIZE 8
+#endif
+
+#if DYNAMIC_CAST_CACHE_SIZE
+static_assert((DYNAMIC_CAST_CACHE_SIZE & (DYNAMIC_CAST_CACHE_SIZE - 1)) == 0,
+              "DYNAMIC_CAST_CACHE_SIZE must be a power of two");
+
+namespace {
+struct dynamic_cast_cache_entry {
+    // Null if the entry is unused.
+    const __class_type_info* dynamic_type;
+    const __class_type_info* static_type;
+    const __class_type_info* dst_type;
+    ptrdiff_t offset_to_derived;
+    // Offset of the result from dynamic_ptr.
+    ptrdiff_t dynamic_to_dst;
+    bool failed;
+    unsigned char seq;
+};
+} // namespace
+
+static dynamic_cast_cache_entry dynamic_cast_cache[DYNAMIC_CAST_CACHE_SIZE];
+
+static dynamic_cast_cache_entry&
+dynamic_cast_cache_slot(const __class_type_info* dynamic_type,
+                        const __class_type_info* static_type,
+                        const __class_type_info* dst_type,
+                        ptrdiff_t offset_to_derived)
+{
+    // type_info objects are at least pointer aligned, so their low bits carry
+    // little information.
+    uintptr_t hash = reinterpret_cast<uintptr_t>(dynamic_type) ^
+                     reinterpret_cast<uintptr_t>(static_type) >> 1 ^
+                     reinterpret_cast<uintptr_t>(dst_type) >> 2 ^
+                     static_cast<uintptr_t>(offset_to_derived);
+    hash ^= hash >> 4;
+    return dynamic_cast_cache[hash & (DYNAMIC_CAST_CACHE_SIZE - 1)];
+}
+#endif // DYNAMIC_CAST_CACHE_SIZE
+
 extern "C" _LIBCXXABI_FUNC_VIS void *
 __dynamic_cast(const void *static_ptr, const __class_type_info *static_type,
                const __class_type_info *dst_type,
                std::ptrdiff_t src2dst_offset) {
-    // Possible future optimization:  Take advantage of src2dst_offset
-
     // Get (dynamic_ptr, dynamic_type) from static_ptr
     void **vtable = *static_cast<void ** const *>(static_ptr);
     ptrdiff_t offset_to_derived = reinterpret_cast<ptrdiff_t>(vtable[-2]);
     const void* dynamic_ptr = static_cast<const char*>(static_ptr) + offset_to_derived;
     const __class_type_info* dynamic_type = static_cast<const __class_type_info*>(vtable[-1]);
 
+    // Find out if we can use a giant short cut in the search
+    bool dynamic_is_dst = is_equal(dynamic_type, dst_type, false);
+
+    // If dst_type is the dynamic type, the only possible answer is
+    //    dynamic_ptr.  When static_type is a unique public nonvirtual base of
+    //    dst_type, the cast succeeds exactly if static_ptr is that base, and
+    //    the vtable's offset to the complete object tells whether it is.
+    if (dynamic_is_dst)
+    {
+        if (src2dst_offset >= 0)
+            return offset_to_derived == -src2dst_offset
+                       ? const_cast<void*>(dynamic_ptr)
+                       : nullptr;
+        if (src2dst_offset == -2)
+            return nullptr;
+    }
+
+#if DYNAMIC_CAST_CACHE_SIZE
+    dynamic_cast_cache_entry& cached = dynamic_cast_cache_slot(
+        dynamic_type, static_type, dst_type, offset_to_derived);
+    unsigned char seq = cached.seq;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    bool hit = !(seq & 1) && cached.dynamic_type == dynamic_type &&
+               cached.static_type == static_type &&
+               cached.dst_type == dst_type &&
+               cached.offset_to_derived == offset_to_derived;
+    bool cached_failed = cached.failed;
+    ptrdiff_t cached_dynamic_to_dst = cached.dynamic_to_dst;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    if (hit && cached.seq == seq)
+    {
+        if (cached_failed)
+            return nullptr;
+        return const_cast<char*>(static_cast<const char*>(dynamic_ptr)) +
+               cached_dynamic_to_dst;
+    }
+#endif
+
     // Initialize answer to nullptr.  This will be changed from the search
     //    results if a non-null answer is found.  Regardless, this is what will
     //    be returned.
@@ -238,8 +327,7 @@ __dynamic_cast(const void *static_ptr, const __class_type_info *static_type,
     // Initialize info struct for this search.
     __dynamic_cast_info info = {dst_type, static_ptr, static_type, src2dst_offset, 0, 0, unknown_path, unknown_path, unknown_path, 0, 0, unknown, 0, 0, 0, 0,};
 
-    // Find out if we can use a giant short cut in the search
-    if (is_equal(dynamic_type, dst_type, false))
+    if (dynamic_is_dst)
     {
         // Using giant short cut.  Add that information to info.
         info.number_of_dst_type = 1;
@@ -251,30 +339,69 @@ __dynamic_cast(const void *static_ptr, const __class_type_info *static_type,
     }
     else
     {
-        // Not using giant short cut.  Do the search
-        dynamic_type->devirt_search_below_dst(&info, dynamic_ptr, public_path, false);
-
-        // Query the search.
-        switch (info.number_to_static_ptr)
+        // When static_type is a unique public nonvirtual base of dst_type,
+        //    the only dst_type that can lead to static_ptr is at
+        //    src2dst_offset below it.  If that object exists, it is the
+        //    answer, and finding it only needs a search above dynamic_ptr
+        //    that stops at the first match.
+        if (src2dst_offset >= 0)
+        {
+            const void* candidate = static_cast<const char*>(static_ptr) - src2dst_offset;
+            if (reinterpret_cast<uintptr_t>(candidate) >= reinterpret_cast<uintptr_t>(dynamic_ptr))
+            {
+                __dynamic_cast_info dst_info = {dynamic_type, candidate, dst_type, src2dst_offset, 0, 0, unknown_path, unknown_path, unknown_path, 0, 0, unknown, 1, 0, 0, 0,};
+                dynamic_type->devirt_search_above_dst(&dst_info, dynamic_ptr, dynamic_ptr, public_path, false);
+                if (dst_info.path_dst_ptr_to_static_ptr != unknown_path)
+                    dst_ptr = candidate;
+            }
+        }
+        if (!dst_ptr)
         {
-        case 0:
-            if (info.number_to_dst_ptr == 1 &&
-                    info.path_dynamic_ptr_to_static_ptr == public_path &&
-                    info.path_dynamic_ptr_to_dst_ptr == public_path)
-                dst_ptr = info.dst_ptr_not_leading_to_static_ptr;
-            break;
-        case 1:
-            if (info.path_dst_ptr_to_static_ptr == public_path ||
-                   (
-                       info.number_to_dst_ptr == 0 &&
-                       info.path_dynamic_ptr_to_static_ptr == public_path &&
-                       info.path_dynamic_ptr_to_dst_ptr == public_path
+            // Not using giant short cut.  Do the search
+            dynamic_type->devirt_search_below_dst(&info, dynamic_ptr, public_path, false);
+
+            // Query the search.
+            switch (info.number_to_static_ptr)
+            {
+            case 0:
+                if (info.number_to_dst_ptr == 1 &&
+                        info.path_dynamic_ptr_to_static_ptr == public_path &&
+                        info.path_dynamic_ptr_to_dst_ptr == public_path)
+                    dst_ptr = info.dst_ptr_not_leading_to_static_ptr;
+                break;
+            case 1:
+                if (info.path_dst_ptr_to_static_ptr == public_path ||
+                       (
+                           info.number_to_dst_ptr == 0 &&
+                           info.path_dynamic_ptr_to_static_ptr == public_path &&
+                           info.path_dynamic_ptr_to_dst_ptr == public_path
+                       )
                    )
-               )
-                dst_ptr = info.dst_ptr_leading_to_static_ptr;
-            break;
+                    dst_ptr = info.dst_ptr_leading_to_static_ptr;
+                break;
+            }
         }
     }
+#if DYNAMIC_CAST_CACHE_SIZE
+    // Keep the sequence number odd while the entry is rewritten, so that a
+    // lookup it interrupts, or that interrupts it, ignores the entry.
+    seq = cached.seq;
+    if (!(seq & 1))
+    {
+        cached.seq = ++seq;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        cached.dynamic_type = dynamic_type;
+        cached.static_type = static_type;
+        cached.dst_type = dst_type;
+        cached.offset_to_derived = offset_to_derived;
+        cached.failed = dst_ptr == 0;
+        if (dst_ptr)
+            cached.dynamic_to_dst = static_cast<const char*>(dst_ptr) -
+                                    static_cast<const char*>(dynamic_ptr);
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+        cached.seq = ++seq;
+    }
+#endif
     return const_cast<void*>(dst_ptr);
 }
 
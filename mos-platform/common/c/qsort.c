@@ -0,0 +1,207 @@
+#include <stdlib.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Partitions with at most this many elements are insertion sorted.
+#define INSERTION_SORT_MAX 8
+
+typedef int (*compar_type)(const void *, const void *);
+
+// Element sizes that are powers of two scale by shifting instead of a
+// multiplication libcall.
+typedef struct {
+  size_t size;
+  // log2(size), or 0xff if size is not a power of two.
+  unsigned char shift;
+} elem_type;
+
+static elem_type _elem(size_t size) {
+  elem_type e = {size, 0};
+  while (e.shift < sizeof(size_t) * 8 && (size_t)1 << e.shift < size)
+    ++e.shift;
+  if ((size_t)1 << e.shift != size)
+    e.shift = 0xff;
+  return e;
+}
+
+static size_t _scale(size_t n, elem_type e) {
+  return e.shift != 0xff ? n << e.shift : n * e.size;
+}
+
+static void _swap(char *a, char *b, size_t size) {
+  switch (size) {
+  case 1: {
+    char t = *a;
+    *a = *b;
+    *b = t;
+    return;
+  }
+  case 2: {
+    uint16_t t, u;
+    memcpy(&t, a, 2);
+    memcpy(&u, b, 2);
+    memcpy(a, &u, 2);
+    memcpy(b, &t, 2);
+    return;
+  }
+  case 4: {
+    uint32_t t, u;
+    memcpy(&t, a, 4);
+    memcpy(&u, b, 4);
+    memcpy(a, &u, 4);
+    memcpy(b, &t, 4);
+    return;
+  }
+  default:
+    for (; size; --size) {
+      char t = *a;
+      *a++ = *b;
+      *b++ = t;
+    }
+  }
+}
+
+static void _insertion_sort(char *lo, char *end, size_t size,
+                            compar_type compar) {
+  for (char *i = lo + size; i < end; i += size)
+    for (char *j = i; j > lo && compar(j - size, j) > 0; j -= size)
+      _swap(j - size, j, size);
+}
+
+// Restores the heap property below the element at byte offset root, in a heap
+// of end bytes.
+static void _sift_down(char *lo, size_t root, size_t end, size_t size,
+                       compar_type compar) {
+  // The children of the element at offset r are at 2r + size and 2r + 2size.
+  while (root < (end - size + 1) >> 1) {
+    size_t child = 2 * root + size;
+    if (child + size < end && compar(lo + child, lo + child + size) < 0)
+      child += size;
+    if (compar(lo + root, lo + child) >= 0)
+      return;
+    _swap(lo + root, lo + child, size);
+    root = child;
+  }
+}
+
+static void _heap_sort(char *lo, size_t n, elem_type e, compar_type compar) {
+  const size_t size = e.size, bytes = _scale(n, e);
+  for (size_t root = _scale(n >> 1, e); root;) {
+    root -= size;
+    _sift_down(lo, root, bytes, size, compar);
+  }
+  for (size_t end = bytes - size; end; end -= size) {
+    _swap(lo, lo + end, size);
+    _sift_down(lo, 0, end, size, compar);
+  }
+}
+
+struct _range {
+  char *lo;
+  size_t n;
+  unsigned char depth;
+};
+
+// An introsort: quicksort with a median of three pivot, falling back to heap
+// sort when partitioning goes badly, and insertion sort for small partitions.
+// The larger side of each partition is deferred to an explicit stack and the
+// smaller is sorted first, so at most log2(nmemb) ranges are ever pending.
+void qsort(void *base, size_t nmemb, size_t size, compar_type compar) {
+  if (nmemb < 2 || !size)
+    return;
+  const elem_type e = _elem(size);
+
+  struct _range stack[sizeof(size_t) * 8];
+  unsigned char pending = 0;
+
+  char *lo = base;
+  size_t n = nmemb;
+  unsigned char depth = 0;
+  for (size_t i = n; i > 1; i >>= 1)
+    depth += 2;
+
+  for (;;) {
+    if (n <= INSERTION_SORT_MAX) {
+      _insertion_sort(lo, lo + _scale(n, e), size, compar);
+    } else if (!depth) {
+      _heap_sort(lo, n, e, compar);
+    } else {
+      --depth;
+      char *mid = lo + _scale(n >> 1, e);
+      char *last = lo + _scale(n - 1, e);
+
+      // Order lo, mid and last, then move the median to lo as the pivot. The
+      // element left at last is then no less than the pivot, so neither scan
+      // below needs a bounds check.
+      if (compar(mid, lo) < 0)
+        _swap(mid, lo, size);
+      if (compar(last, mid) < 0) {
+        _swap(last, mid, size);
+        if (compar(mid, lo) < 0)
+          _swap(mid, lo, size);
+      }
+      _swap(lo, mid, size);
+
+      char *i = lo, *j = last + size;
+      size_t left = n;
+      for (;;) {
+        do
+          i += size;
+        while (compar(i, lo) < 0);
+        do {
+          j -= size;
+          --left;
+        } while (compar(j, lo) > 0);
+        if (i >= j)
+          break;
+        _swap(i, j, size);
+      }
+      // Move the pivot between the partitions. left is now the index of j.
+      _swap(lo, j, size);
+      size_t right = n - left - 1;
+
+      struct _range *r = &stack[pending++];
+      r->depth = depth;
+      if (left < right) {
+        r->lo = j + size;
+        r->n = right;
+        n = left;
+      } else {
+        r->lo = lo;
+        r->n = left;
+        lo = j + size;
+        n = right;
+      }
+      continue;
+    }
+
+    if (!pending)
+      return;
+    struct _range *r = &stack[--pending];
+    lo = r->lo;
+    n = r->n;
+    depth = r->depth;
+  }
+}
+
+void *bsearch(const void *key, const void *base, size_t nmemb, size_t size,
+              compar_type compar) {
+  const elem_type e = _elem(size);
+  const char *lo = base;
+  while (nmemb) {
+    size_t half = nmemb >> 1;
+    const char *mid = lo + _scale(half, e);
+    int c = compar(key, mid);
+    if (!c)
+      return (void *)mid;
+    if (c > 0) {
+      lo = mid + size;
+      nmemb -= half + 1;
+    } else {
+      nmemb = half;
+    }
+  }
+  return NULL;
+}
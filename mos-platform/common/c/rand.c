@@ -0,0 +1,25 @@
+#include <stdlib.h>
+
+#include <stdint.h>
+
+// A 16-bit xorshift generator with shifts (7, 9, 8). It visits every nonzero
+// state once in 65535 steps, and needs no multiplication: a shift by 8 just
+// moves a byte, and 9 is a byte move and one shift.
+static uint16_t state = 1;
+
+static uint16_t next(void) {
+  uint16_t x = state;
+  x ^= x << 7;
+  x ^= x >> 9;
+  x ^= x << 8;
+  return state = x;
+}
+
+int rand(void) { return next() & RAND_MAX; }
+
+unsigned char __rand8(void) { return next(); }
+
+void srand(unsigned seed) {
+  // Zero would stay zero forever.
+  state = seed ? seed : 1;
+}
@@ -0,0 +1,158 @@
+#include <ctype.h>
+#include <stdlib.h>
+
+// Value of digit c in bases up to 36, or at least 36 if c is not a digit.
+static unsigned char digit_value(char c) {
+  if ((unsigned char)(c - '0') < 10)
+    return c - '0';
+  // Fold letters to lower case.
+  c |= 0x20;
+  if ((unsigned char)(c - 'a') < 26)
+    return c - 'a' + 10;
+  return 36;
+}
+
+// Parses an integer as strtoul does, accumulating it in the unsigned type U.
+// The magnitude is clamped to pos_limit or neg_limit, depending on the sign;
+// sets overflow if that happens.
+//
+// Multiplying by the base uses shifts for base 10 and powers of two, so the
+// common cases never call the multiplication libcalls. The overflow checks
+// compare against constants, except in other bases.
+template <typename U>
+static U parse(const char *nptr, char **endptr, int base, U pos_limit,
+               U neg_limit, bool &negative, bool &overflow) {
+  constexpr U max = (U)-1;
+  constexpr unsigned char bits = sizeof(U) * 8;
+  const char *s = nptr;
+  negative = false;
+  overflow = false;
+  if (base < 0 || base == 1 || base > 36) {
+    if (endptr)
+      *endptr = const_cast<char *>(nptr);
+    return 0;
+  }
+
+  while (__ctype_is(*s, __CTYPE_SPACE))
+    ++s;
+  if (*s == '-') {
+    negative = true;
+    ++s;
+  } else if (*s == '+') {
+    ++s;
+  }
+  if ((base == 0 || base == 16) && s[0] == '0' && (s[1] | 0x20) == 'x' &&
+      digit_value(s[2]) < 16) {
+    s += 2;
+    base = 16;
+  } else if (base == 0) {
+    base = s[0] == '0' ? 8 : 10;
+  }
+
+  unsigned char shift = 0;
+  for (unsigned char b = base; !(b & 1); b >>= 1)
+    ++shift;
+  if (base != 1 << shift)
+    shift = 0;
+  const U max_before_mul = base == 10 || shift ? 0 : max / (unsigned char)base;
+
+  const char *digits = s;
+  U value = 0;
+  for (;; ++s) {
+    unsigned char d = digit_value(*s);
+    if (d >= base)
+      break;
+    if (overflow)
+      continue;
+    if (base == 10) {
+      if (value > max / 10) {
+        overflow = true;
+        continue;
+      }
+      value = ((value << 2) + value) << 1;
+    } else if (shift) {
+      if (value >> (bits - shift)) {
+        overflow = true;
+        continue;
+      }
+      value <<= shift;
+    } else {
+      if (value > max_before_mul) {
+        overflow = true;
+        continue;
+      }
+      value *= (unsigned char)base;
+    }
+    value += d;
+    if (value < d)
+      overflow = true;
+  }
+
+  if (endptr)
+    *endptr = const_cast<char *>(s == digits ? nptr : s);
+  const U limit = negative ? neg_limit : pos_limit;
+  if (overflow || value > limit) {
+    overflow = true;
+    return limit;
+  }
+  return value;
+}
+
+template <typename T, typename U>
+static T strto_signed(const char *nptr, char **endptr, int base) {
+  constexpr U max = (U)-1 >> 1;
+  bool negative, overflow;
+  U value = parse<U>(nptr, endptr, base, max, max + 1, negative, overflow);
+  return negative ? (T)-value : (T)value;
+}
+
+// As in strtoul, a negative number is negated as unsigned, and out of range
+// values become the maximum whatever their sign.
+template <typename U>
+static U strto_unsigned(const char *nptr, char **endptr, int base) {
+  bool negative, overflow;
+  U value = parse<U>(nptr, endptr, base, (U)-1, (U)-1, negative, overflow);
+  if (overflow)
+    return (U)-1;
+  return negative ? -value : value;
+}
+
+extern "C" {
+
+int atoi(const char *s) {
+  return strto_signed<int, unsigned>(s, nullptr, 10);
+}
+long atol(const char *s) {
+  return strto_signed<long, unsigned long>(s, nullptr, 10);
+}
+long long atoll(const char *s) {
+  return strto_signed<long long, unsigned long long>(s, nullptr, 10);
+}
+
+long strtol(const char *nptr, char **endptr, int base) {
+  return strto_signed<long, unsigned long>(nptr, endptr, base);
+}
+long long strtoll(const char *nptr, char **endptr, int base) {
+  return strto_signed<long long, unsigned long long>(nptr, endptr, base);
+}
+unsigned long strtoul(const char *nptr, char **endptr, int base) {
+  return strto_unsigned<unsigned long>(nptr, endptr, base);
+}
+unsigned long long strtoull(const char *nptr, char **endptr, int base) {
+  return strto_unsigned<unsigned long long>(nptr, endptr, base);
+}
+
+signed char __strtoi8(const char *nptr, char **endptr, int base) {
+  return strto_signed<signed char, unsigned char>(nptr, endptr, base);
+}
+unsigned char __strtou8(const char *nptr, char **endptr, int base) {
+  return strto_unsigned<unsigned char>(nptr, endptr, base);
+}
+int __strtoi16(const char *nptr, char **endptr, int base) {
+  return strto_signed<int, unsigned>(nptr, endptr, base);
+}
+unsigned __strtou16(const char *nptr, char **endptr, int base) {
+  return strto_unsigned<unsigned>(nptr, endptr, base);
+}
+
+}
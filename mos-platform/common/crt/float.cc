@@ -0,0 +1,485 @@
+// IEEE 754 soft float, rounding to nearest even. The same templates implement
+// both formats; they are tuned for float, the format most 6502 code can
+// afford.
+//
+// Results carry three extra bits below the significand while in flight:
+// guard, round, and a sticky bit that is set if anything nonzero was shifted
+// out below them. That is all round to nearest even needs.
+
+#include <stdint.h>
+
+namespace {
+
+struct sf {
+  typedef float type;
+  typedef uint32_t rep;
+  static constexpr char mant_bits = 23;
+  static constexpr int exp_max = 0xff;
+};
+
+struct df {
+  typedef double type;
+  typedef uint64_t rep;
+  static constexpr char mant_bits = 52;
+  static constexpr int exp_max = 0x7ff;
+};
+
+template <class F> struct fmt : F {
+  typedef typename F::rep rep;
+  static constexpr char bits = sizeof(rep) * 8;
+  static constexpr int bias = F::exp_max >> 1;
+  static constexpr rep sign = (rep)1 << (bits - 1);
+  static constexpr rep implicit = (rep)1 << F::mant_bits;
+  static constexpr rep mant_mask = implicit - 1;
+  static constexpr rep quiet = implicit >> 1;
+  static constexpr rep inf = (rep)F::exp_max << F::mant_bits;
+  static constexpr rep nan = inf | quiet;
+  // The leading one of an in-flight significand.
+  static constexpr rep lead = implicit << 3;
+};
+
+template <class F> typename F::rep to_rep(typename F::type x) {
+  typename F::rep r;
+  __builtin_memcpy(&r, &x, sizeof(r));
+  return r;
+}
+
+template <class F> typename F::type from_rep(typename F::rep r) {
+  typename F::type x;
+  __builtin_memcpy(&x, &r, sizeof(x));
+  return x;
+}
+
+// Shifts right, ORing anything shifted out into the low bit.
+template <class T> T shr_sticky(T v, int n) {
+  if (n >= (int)sizeof(T) * 8)
+    return v != 0;
+  // Whole bytes first; variable shifts are loops of single bit shifts.
+  bool sticky = false;
+  for (; n >= 8; n -= 8) {
+    sticky |= (uint8_t)v;
+    v >>= 8;
+  }
+  for (; n; --n) {
+    sticky |= v & 1;
+    v >>= 1;
+  }
+  return v | sticky;
+}
+
+// Returns the exponent of a nonzero finite magnitude, and its significand
+// with the leading one at mant_bits, normalizing subnormals.
+template <class F> int unpack(typename F::rep a_abs, typename F::rep *sig) {
+  using G = fmt<F>;
+  int exp = a_abs >> F::mant_bits;
+  *sig = a_abs & G::mant_mask;
+  if (exp) {
+    *sig |= G::implicit;
+  } else {
+    exp = 1;
+    while (!(*sig & G::implicit)) {
+      *sig <<= 1;
+      --exp;
+    }
+  }
+  return exp;
+}
+
+// Rounds and packs a result whose significand has its leading one at bit
+// mant_bits + 3, or lower only if the result is subnormal with exp == 1.
+template <class F>
+typename F::rep round_pack(bool negative, int exp, typename F::rep sig) {
+  using G = fmt<F>;
+  typedef typename F::rep rep;
+  const rep sign = negative ? G::sign : 0;
+  if (exp >= F::exp_max)
+    return sign | G::inf;
+  if (exp <= 0) {
+    sig = shr_sticky(sig, 1 - exp);
+    exp = 1;
+  }
+  uint8_t low = sig & 7;
+  sig >>= 3;
+  if (low > 4 || (low == 4 && (sig & 1)))
+    ++sig;
+  // The implicit bit, if present, adds the last one to the exponent. A
+  // rounding carry out of the significand lands in the exponent too, which is
+  // exactly right, including overflow to infinity.
+  return sign | (sig + ((rep)(exp - 1) << F::mant_bits));
+}
+
+template <class F> typename F::rep add(typename F::rep a, typename F::rep b) {
+  using G = fmt<F>;
+  typedef typename F::rep rep;
+  rep a_abs = a & ~G::sign;
+  rep b_abs = b & ~G::sign;
+
+  if (a_abs > G::inf)
+    return a | G::quiet;
+  if (b_abs > G::inf)
+    return b | G::quiet;
+  if (a_abs == G::inf)
+    return b_abs == G::inf && (a ^ b) & G::sign ? G::nan : a;
+  if (b_abs == G::inf)
+    return b;
+  if (!a_abs)
+    // -0 + -0 is -0; any other sum of zeroes is +0.
+    return b_abs ? b : a & b;
+  if (!b_abs)
+    return a;
+
+  // Make a the larger magnitude; the result takes its sign.
+  if (a_abs < b_abs) {
+    rep t = a;
+    a = b;
+    b = t;
+    t = a_abs;
+    a_abs = b_abs;
+    b_abs = t;
+  }
+
+  // Subnormals get exponent 1 and no implicit bit, without normalizing; the
+  // sum is then correctly left for round_pack as is.
+  int a_exp = a_abs >> F::mant_bits;
+  int b_exp = b_abs >> F::mant_bits;
+  rep a_sig = a_abs & G::mant_mask;
+  rep b_sig = b_abs & G::mant_mask;
+  if (a_exp)
+    a_sig |= G::implicit;
+  else
+    a_exp = 1;
+  if (b_exp)
+    b_sig |= G::implicit;
+  else
+    b_exp = 1;
+  a_sig <<= 3;
+  b_sig = shr_sticky(b_sig << 3, a_exp - b_exp);
+
+  if ((a ^ b) & G::sign) {
+    a_sig -= b_sig;
+    if (!a_sig)
+      return 0;
+    // Cancellation can clear any number of leading bits, but stop at the
+    // subnormal range.
+    while (!(a_sig & G::lead) && a_exp > 1) {
+      a_sig <<= 1;
+      --a_exp;
+    }
+  } else {
+    a_sig += b_sig;
+    if (a_sig & G::lead << 1) {
+      a_sig = a_sig >> 1 | (a_sig & 1);
+      ++a_exp;
+    }
+  }
+  return round_pack<F>(a & G::sign, a_exp, a_sig);
+}
+
+// Multiplies two magnitudes byte by byte into a double-width product, so each
+// step is an 8x8 multiply; the high bytes of float significands are zero and
+// skipped.
+template <class T> void mul_wide(T a, T b, T *hi, T *lo) {
+  uint8_t ab[sizeof(T)], bb[sizeof(T)], p[sizeof(T) * 2] = {};
+  __builtin_memcpy(ab, &a, sizeof(T));
+  __builtin_memcpy(bb, &b, sizeof(T));
+  uint8_t b_len = sizeof(T);
+  while (!bb[b_len - 1])
+    --b_len;
+  for (uint8_t i = 0; i < sizeof(T); ++i) {
+    if (!ab[i])
+      continue;
+    uint8_t carry = 0;
+    for (uint8_t j = 0; j < b_len; ++j) {
+      uint16_t t = (uint16_t)ab[i] * bb[j] + p[i + j] + carry;
+      p[i + j] = t;
+      carry = t >> 8;
+    }
+    p[i + b_len] = carry;
+  }
+  __builtin_memcpy(lo, p, sizeof(T));
+  __builtin_memcpy(hi, p + sizeof(T), sizeof(T));
+}
+
+template <class F> typename F::rep mul(typename F::rep a, typename F::rep b) {
+  using G = fmt<F>;
+  typedef typename F::rep rep;
+  const rep a_abs = a & ~G::sign;
+  const rep b_abs = b & ~G::sign;
+  const rep sign = (a ^ b) & G::sign;
+
+  if (a_abs > G::inf)
+    return a | G::quiet;
+  if (b_abs > G::inf)
+    return b | G::quiet;
+  if (a_abs == G::inf || b_abs == G::inf)
+    return a_abs && b_abs ? sign | G::inf : G::nan;
+  if (!a_abs || !b_abs)
+    return sign;
+
+  rep a_sig, b_sig;
+  int exp = unpack<F>(a_abs, &a_sig) + unpack<F>(b_abs, &b_sig) - G::bias;
+
+  // The product has its leading one at bit 2 * mant_bits or one above.
+  // Shift that down to mant_bits + 3, keeping a sticky bit.
+  rep hi, lo;
+  mul_wide(a_sig, b_sig, &hi, &lo);
+  constexpr char shift = F::mant_bits - 3;
+  rep sig = hi << (G::bits - shift) | lo >> shift | (lo << (G::bits - shift) != 0);
+  if (sig & G::lead << 1) {
+    sig = sig >> 1 | (sig & 1);
+    ++exp;
+  }
+  return round_pack<F>(sign, exp, sig);
+}
+
+template <class F> typename F::rep div(typename F::rep a, typename F::rep b) {
+  using G = fmt<F>;
+  typedef typename F::rep rep;
+  const rep a_abs = a & ~G::sign;
+  const rep b_abs = b & ~G::sign;
+  const rep sign = (a ^ b) & G::sign;
+
+  if (a_abs > G::inf)
+    return a | G::quiet;
+  if (b_abs > G::inf)
+    return b | G::quiet;
+  if (a_abs == G::inf)
+    return b_abs == G::inf ? G::nan : sign | G::inf;
+  if (b_abs == G::inf)
+    return sign;
+  if (!b_abs)
+    return a_abs ? sign | G::inf : G::nan;
+  if (!a_abs)
+    return sign;
+
+  rep a_sig, b_sig;
+  int exp = unpack<F>(a_abs, &a_sig) - unpack<F>(b_abs, &b_sig) + G::bias;
+  if (a_sig < b_sig) {
+    a_sig <<= 1;
+    --exp;
+  }
+
+  // Restoring division, one quotient bit per step; the first is always one.
+  rep q = 0;
+  for (uint8_t i = 0; i < F::mant_bits + 4; ++i) {
+    q <<= 1;
+    if (a_sig >= b_sig) {
+      a_sig -= b_sig;
+      q |= 1;
+    }
+    a_sig <<= 1;
+  }
+  return round_pack<F>(sign, exp, q | (a_sig != 0));
+}
+
+// Returns -1, 0, or 1 as a is less than, equal to, or greater than b, and
+// unordered if either is a NaN.
+template <class F> int cmp(typename F::rep a, typename F::rep b, int unordered) {
+  using G = fmt<F>;
+  const typename F::rep a_abs = a & ~G::sign;
+  const typename F::rep b_abs = b & ~G::sign;
+  if (a_abs > G::inf || b_abs > G::inf)
+    return unordered;
+  if (!a_abs && !b_abs)
+    return 0;
+  const bool a_neg = a & G::sign;
+  if (a_neg != (bool)(b & G::sign))
+    return a_neg ? -1 : 1;
+  if (a == b)
+    return 0;
+  return (a < b) != a_neg ? -1 : 1;
+}
+
+template <class F> bool unord(typename F::rep a, typename F::rep b) {
+  using G = fmt<F>;
+  return (a & ~G::sign) > G::inf || (b & ~G::sign) > G::inf;
+}
+
+template <class F, class U> typename F::rep from_int(bool negative, U u) {
+  using G = fmt<F>;
+  typedef typename F::rep rep;
+  if (!u)
+    return 0;
+  constexpr char bits = sizeof(U) * 8;
+  char msb = bits - 1;
+  while (!(u >> (bits - 8))) {
+    u <<= 8;
+    msb -= 8;
+  }
+  while (!(u >> (bits - 1))) {
+    u <<= 1;
+    --msb;
+  }
+  // Now the leading one is at bits - 1; move it to mant_bits + 3.
+  constexpr int shift = bits - 1 - (F::mant_bits + 3);
+  rep sig;
+  if constexpr (shift > 0)
+    sig = shr_sticky(u, shift);
+  else
+    sig = (rep)u << -shift;
+  return round_pack<F>(negative, G::bias + msb, sig);
+}
+
+template <class S> struct make_unsigned;
+template <> struct make_unsigned<long> { typedef unsigned long type; };
+template <> struct make_unsigned<long long> {
+  typedef unsigned long long type;
+};
+
+template <class F, class S> typename F::rep from_sint(S s) {
+  typedef typename make_unsigned<S>::type U;
+  // Negating in unsigned arithmetic handles the most negative value.
+  return from_int<F, U>(s < 0, s < 0 ? (U)0 - (U)s : (U)s);
+}
+
+// The magnitude of a, truncated toward zero and saturated to U.
+template <class F, class U> U to_uint(typename F::rep a) {
+  using G = fmt<F>;
+  typedef typename F::rep rep;
+  const rep a_abs = a & ~G::sign;
+  if (a_abs > G::inf)
+    return 0;
+  int exp = (int)(a_abs >> F::mant_bits) - G::bias;
+  if (exp < 0)
+    return 0;
+  if (exp >= (int)sizeof(U) * 8)
+    return (U)-1;
+  const rep sig = (a_abs & G::mant_mask) | G::implicit;
+  if (exp > F::mant_bits)
+    return (U)sig << (exp - F::mant_bits);
+  return sig >> (F::mant_bits - exp);
+}
+
+template <class F, class S> S to_sint(typename F::rep a) {
+  typedef typename make_unsigned<S>::type U;
+  const U limit = (U)1 << (sizeof(S) * 8 - 1);
+  const U m = to_uint<F, U>(a);
+  if (a & fmt<F>::sign)
+    return m >= limit ? (S)limit : -(S)m;
+  return m >= limit ? (S)(limit - 1) : (S)m;
+}
+
+template <class To, class From>
+typename To::rep convert(typename From::rep a) {
+  using G = fmt<From>;
+  using H = fmt<To>;
+  typedef typename To::rep rep;
+  const typename From::rep a_abs = a & ~G::sign;
+  const rep sign = a & G::sign ? H::sign : 0;
+
+  if (a_abs > G::inf) {
+    // Keep the top of the payload.
+    if constexpr (To::mant_bits > From::mant_bits)
+      return sign | H::nan |
+             (rep)(a_abs & G::mant_mask) << (To::mant_bits - From::mant_bits);
+    else
+      return sign | H::nan |
+             (rep)((a_abs & G::mant_mask) >> (From::mant_bits - To::mant_bits));
+  }
+  if (a_abs == G::inf)
+    return sign | H::inf;
+  if (!a_abs)
+    return sign;
+
+  typename From::rep sig;
+  int exp = unpack<From>(a_abs, &sig) - G::bias + H::bias;
+  constexpr int shift = From::mant_bits - (To::mant_bits + 3);
+  rep s;
+  if constexpr (shift > 0)
+    s = shr_sticky(sig, shift);
+  else
+    s = (rep)sig << -shift;
+  return round_pack<To>(sign, exp, s);
+}
+
+} // namespace
+
+extern "C" {
+
+#define BINARY(name, op, F)                                                    \
+  F::type name(F::type a, F::type b) {                                         \
+    return from_rep<F>(op<F>(to_rep<F>(a), to_rep<F>(b)));                     \
+  }
+
+// The comparisons return the value for unordered operands that makes the
+// corresponding C comparison false. The result is long, as in compiler-rt, so
+// it is right however wide the compiler reads it.
+#define COMPARE(F, suffix)                                                     \
+  long __eq##suffix##2(F::type a, F::type b) {                                 \
+    return cmp<F>(to_rep<F>(a), to_rep<F>(b), 1);                              \
+  }                                                                            \
+  long __ne##suffix##2(F::type a, F::type b) {                                 \
+    return cmp<F>(to_rep<F>(a), to_rep<F>(b), 1);                              \
+  }                                                                            \
+  long __lt##suffix##2(F::type a, F::type b) {                                 \
+    return cmp<F>(to_rep<F>(a), to_rep<F>(b), 1);                              \
+  }                                                                            \
+  long __le##suffix##2(F::type a, F::type b) {                                 \
+    return cmp<F>(to_rep<F>(a), to_rep<F>(b), 1);                              \
+  }                                                                            \
+  long __gt##suffix##2(F::type a, F::type b) {                                 \
+    return cmp<F>(to_rep<F>(a), to_rep<F>(b), -1);                             \
+  }                                                                            \
+  long __ge##suffix##2(F::type a, F::type b) {                                 \
+    return cmp<F>(to_rep<F>(a), to_rep<F>(b), -1);                             \
+  }                                                                            \
+  long __unord##suffix##2(F::type a, F::type b) {                              \
+    return unord<F>(to_rep<F>(a), to_rep<F>(b));                               \
+  }
+
+#define CONVERT(F, suffix)                                                     \
+  F::type __floatsi##suffix(long i) { return from_rep<F>(from_sint<F>(i)); }   \
+  F::type __floatunsi##suffix(unsigned long i) {                               \
+    return from_rep<F>(from_int<F>(false, i));                                 \
+  }                                                                            \
+  F::type __floatdi##suffix(long long i) {                                     \
+    return from_rep<F>(from_sint<F>(i));                                       \
+  }                                                                            \
+  F::type __floatundi##suffix(unsigned long long i) {                          \
+    return from_rep<F>(from_int<F>(false, i));                                 \
+  }                                                                            \
+  long __fix##suffix##si(F::type a) { return to_sint<F, long>(to_rep<F>(a)); } \
+  unsigned long __fixuns##suffix##si(F::type a) {                              \
+    const F::rep r = to_rep<F>(a);                                             \
+    return r & fmt<F>::sign ? 0 : to_uint<F, unsigned long>(r);                \
+  }                                                                            \
+  long long __fix##suffix##di(F::type a) {                                     \
+    return to_sint<F, long long>(to_rep<F>(a));                                \
+  }                                                                            \
+  unsigned long long __fixuns##suffix##di(F::type a) {                         \
+    const F::rep r = to_rep<F>(a);                                             \
+    return r & fmt<F>::sign ? 0 : to_uint<F, unsigned long long>(r);           \
+  }                                                                            \
+  F::type __neg##suffix##2(F::type a) {                                        \
+    return from_rep<F>(to_rep<F>(a) ^ fmt<F>::sign);                           \
+  }
+
+BINARY(__addsf3, add, sf)
+BINARY(__mulsf3, mul, sf)
+BINARY(__divsf3, div, sf)
+float __subsf3(float a, float b) {
+  return from_rep<sf>(add<sf>(to_rep<sf>(a), to_rep<sf>(b) ^ fmt<sf>::sign));
+}
+COMPARE(sf, sf)
+CONVERT(sf, sf)
+
+// Double is only a distinct format where it is wider than float.
+#if __SIZEOF_DOUBLE__ == 8
+BINARY(__adddf3, add, df)
+BINARY(__muldf3, mul, df)
+BINARY(__divdf3, div, df)
+double __subdf3(double a, double b) {
+  return from_rep<df>(add<df>(to_rep<df>(a), to_rep<df>(b) ^ fmt<df>::sign));
+}
+COMPARE(df, df)
+CONVERT(df, df)
+
+double __extendsfdf2(float a) {
+  return from_rep<df>(convert<df, sf>(to_rep<sf>(a)));
+}
+float __truncdfsf2(double a) {
+  return from_rep<sf>(convert<sf, df>(to_rep<df>(a)));
+}
+#endif
+
+} // extern "C"
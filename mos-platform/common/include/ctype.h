@@ -5,7 +5,59 @@
 extern "C" {
 #endif
 
+int isalnum(int c);
+int isalpha(int c);
+int isblank(int c);
+int iscntrl(int c);
+int isdigit(int c);
+int isgraph(int c);
+int islower(int c);
 int isprint(int c);
+int ispunct(int c);
+int isspace(int c);
+int isupper(int c);
+int isxdigit(int c);
+
+int tolower(int c);
+int toupper(int c);
+
+// Character classes of each unsigned char value, as a mask of the following
+// bits. EOF converts to 0xff, which belongs to no class.
+extern const unsigned char __ctype[256];
+
+#define __CTYPE_UPPER 0x01
+#define __CTYPE_LOWER 0x02
+#define __CTYPE_DIGIT 0x04
+// Whitespace: ' ', '\t', '\n', '\v', '\f', '\r'.
+#define __CTYPE_SPACE 0x08
+#define __CTYPE_PUNCT 0x10
+#define __CTYPE_CNTRL 0x20
+// Hexadecimal digits that are letters.
+#define __CTYPE_HEX 0x40
+// The space character only.
+#define __CTYPE_BLANK 0x80
+
+#define __ctype_is(c, mask) (__ctype[(unsigned char)(c)] & (mask))
+
+// Classify with an inline table lookup instead of a call. Each macro
+// evaluates its argument once. As with any library macro, the function is
+// still available as (isdigit)(c), or after #undef.
+#ifndef __cplusplus
+#define isalnum(c) __ctype_is(c, __CTYPE_UPPER | __CTYPE_LOWER | __CTYPE_DIGIT)
+#define isalpha(c) __ctype_is(c, __CTYPE_UPPER | __CTYPE_LOWER)
+#define iscntrl(c) __ctype_is(c, __CTYPE_CNTRL)
+#define isdigit(c) __ctype_is(c, __CTYPE_DIGIT)
+#define isgraph(c)                                                             \
+  __ctype_is(c, __CTYPE_UPPER | __CTYPE_LOWER | __CTYPE_DIGIT | __CTYPE_PUNCT)
+#define islower(c) __ctype_is(c, __CTYPE_LOWER)
+#define isprint(c)                                                             \
+  __ctype_is(c, __CTYPE_UPPER | __CTYPE_LOWER | __CTYPE_DIGIT |                \
+                    __CTYPE_PUNCT | __CTYPE_BLANK)
+#define ispunct(c) __ctype_is(c, __CTYPE_PUNCT)
+#define isspace(c) __ctype_is(c, __CTYPE_SPACE)
+#define isupper(c) __ctype_is(c, __CTYPE_UPPER)
+#define isxdigit(c) __ctype_is(c, __CTYPE_DIGIT | __CTYPE_HEX)
+#endif
 
 #ifdef __cplusplus
 }
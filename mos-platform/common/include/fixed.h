@@ -0,0 +1,137 @@
+#ifndef _FIXED_H_
+#define _FIXED_H_
+
+// Fixed-point arithmetic, in the math library (-lm).
+//
+// fix8_t holds a signed 8.8 value, and fix16_t a signed 16.16 value. Results
+// that do not fit wrap around, except that division by zero saturates.
+//
+// Angles are binary, so they wrap around for free: a full turn is 256 for the
+// fix8 functions and 65536 for the fix16 functions.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int16_t fix8_t;
+typedef int32_t fix16_t;
+
+#define FIX8_ONE ((fix8_t)0x100)
+#define FIX16_ONE ((fix16_t)0x10000)
+
+// Converts a floating-point constant, rounding to nearest. Only use this with
+// constants; anything else needs soft float at run time.
+#define FIX8(x) ((fix8_t)((x)*256.0 + ((x) < 0 ? -0.5 : 0.5)))
+#define FIX16(x) ((fix16_t)((x)*65536.0 + ((x) < 0 ? -0.5 : 0.5)))
+
+#define FIX8_FROM_INT(i) ((fix8_t)((i)*256))
+#define FIX16_FROM_INT(i) ((fix16_t)(i)*65536)
+// Rounds toward negative infinity.
+#define FIX8_TO_INT(x) ((x) >> 8)
+#define FIX16_TO_INT(x) ((x) >> 16)
+#define FIX8_TO_FIX16(x) ((fix16_t)(x)*256)
+#define FIX16_TO_FIX8(x) ((fix8_t)((x) >> 8))
+
+// Products are rounded to nearest; quotients toward zero.
+fix8_t fix8_mul(fix8_t a, fix8_t b);
+fix8_t fix8_div(fix8_t a, fix8_t b);
+fix16_t fix16_mul(fix16_t a, fix16_t b);
+fix16_t fix16_div(fix16_t a, fix16_t b);
+
+// Square roots, rounded to nearest. Negative arguments give zero.
+fix8_t fix8_sqrt(fix8_t x);
+fix16_t fix16_sqrt(fix16_t x);
+
+// Sine and cosine by table lookup. The fix16 versions interpolate linearly and
+// are accurate to within about 1/32768.
+fix8_t fix8_sin(uint8_t angle);
+fix8_t fix8_cos(uint8_t angle);
+fix16_t fix16_sin(uint16_t angle);
+fix16_t fix16_cos(uint16_t angle);
+
+// The angle of the vector (x, y), counterclockwise from the positive x axis,
+// from a table of arctangents. Zero for the zero vector. The fix16 version is
+// accurate to within about 4/65536 of a turn.
+uint8_t fix8_atan2(fix8_t y, fix8_t x);
+uint16_t fix16_atan2(fix16_t y, fix16_t x);
+
+#ifdef __cplusplus
+}
+
+template <class Raw> struct __fixed_ops;
+
+template <> struct __fixed_ops<fix8_t> {
+  using angle = uint8_t;
+  static constexpr int frac_bits = 8;
+  static fix8_t mul(fix8_t a, fix8_t b) { return fix8_mul(a, b); }
+  static fix8_t div(fix8_t a, fix8_t b) { return fix8_div(a, b); }
+  static fix8_t sqrt(fix8_t x) { return fix8_sqrt(x); }
+  static fix8_t sin(angle a) { return fix8_sin(a); }
+  static fix8_t cos(angle a) { return fix8_cos(a); }
+  static angle atan2(fix8_t y, fix8_t x) { return fix8_atan2(y, x); }
+};
+
+template <> struct __fixed_ops<fix16_t> {
+  using angle = uint16_t;
+  static constexpr int frac_bits = 16;
+  static fix16_t mul(fix16_t a, fix16_t b) { return fix16_mul(a, b); }
+  static fix16_t div(fix16_t a, fix16_t b) { return fix16_div(a, b); }
+  static fix16_t sqrt(fix16_t x) { return fix16_sqrt(x); }
+  static fix16_t sin(angle a) { return fix16_sin(a); }
+  static fix16_t cos(angle a) { return fix16_cos(a); }
+  static angle atan2(fix16_t y, fix16_t x) { return fix16_atan2(y, x); }
+};
+
+// A fixed-point number with the usual operators. Constants can be written as
+// fix16(1.5); like FIX16, this is only free for constants.
+template <class Raw> class __fixed {
+  using ops = __fixed_ops<Raw>;
+  static constexpr Raw one = (Raw)1 << ops::frac_bits;
+  Raw v;
+
+public:
+  using angle = typename ops::angle;
+
+  constexpr __fixed() : v(0) {}
+  constexpr __fixed(int i) : v((Raw)(i * one)) {}
+  constexpr explicit __fixed(double d)
+      : v((Raw)(d * one + (d < 0 ? -0.5 : 0.5))) {}
+  static constexpr __fixed from_raw(Raw r) {
+    __fixed f;
+    f.v = r;
+    return f;
+  }
+  constexpr Raw raw() const { return v; }
+  constexpr int to_int() const { return v >> ops::frac_bits; }
+
+  constexpr __fixed operator+(__fixed o) const { return from_raw(v + o.v); }
+  constexpr __fixed operator-(__fixed o) const { return from_raw(v - o.v); }
+  constexpr __fixed operator-() const { return from_raw(-v); }
+  __fixed operator*(__fixed o) const { return from_raw(ops::mul(v, o.v)); }
+  __fixed operator/(__fixed o) const { return from_raw(ops::div(v, o.v)); }
+  __fixed &operator+=(__fixed o) { return *this = *this + o; }
+  __fixed &operator-=(__fixed o) { return *this = *this - o; }
+  __fixed &operator*=(__fixed o) { return *this = *this * o; }
+  __fixed &operator/=(__fixed o) { return *this = *this / o; }
+
+  constexpr bool operator==(__fixed o) const { return v == o.v; }
+  constexpr bool operator!=(__fixed o) const { return v != o.v; }
+  constexpr bool operator<(__fixed o) const { return v < o.v; }
+  constexpr bool operator<=(__fixed o) const { return v <= o.v; }
+  constexpr bool operator>(__fixed o) const { return v > o.v; }
+  constexpr bool operator>=(__fixed o) const { return v >= o.v; }
+
+  static __fixed sin(angle a) { return from_raw(ops::sin(a)); }
+  static __fixed cos(angle a) { return from_raw(ops::cos(a)); }
+  static angle atan2(__fixed y, __fixed x) { return ops::atan2(y.v, x.v); }
+  friend __fixed sqrt(__fixed x) { return from_raw(ops::sqrt(x.v)); }
+};
+
+using fix8 = __fixed<fix8_t>;
+using fix16 = __fixed<fix16_t>;
+
+#endif // __cplusplus
+
+#endif // not _FIXED_H_
@@ -14,6 +14,8 @@ extern "C" {
 #define EXIT_SUCCESS 0
 #define EXIT_FAILURE 1
 
+#define RAND_MAX 0x7fff
+
 void exit(int status);
 __attribute__((leaf)) void abort(void);
 __attribute__((leaf)) void _exit(int status);
@@ -21,10 +23,66 @@ __attribute__((leaf)) void _Exit(int status);
 
 int atexit(void (*function)(void));
 
+// Not stable. Elements of 1, 2 and 4 bytes are swapped whole, and sizes that
+// are powers of two avoid multiplication. The C++ <algorithm> header provides
+// std::sort, which inlines the comparison.
+void qsort(void *base, size_t nmemb, size_t size,
+           int (*compar)(const void *, const void *));
+void *bsearch(const void *key, const void *base, size_t nmemb, size_t size,
+              int (*compar)(const void *, const void *));
+
+// Pseudo-random numbers from a 16-bit xorshift generator, which repeats every
+// 65535 calls. The generator uses only shifts and exclusive ors.
+int rand(void);
+void srand(unsigned seed);
+// A random byte from the same generator, without the conversion to int.
+unsigned char __rand8(void);
+
 int abs(int i);
 long labs(long i);
 long long llabs(long long i);
 
+int atoi(const char *s);
+long atol(const char *s);
+long long atoll(const char *s);
+
+// errno is not set on overflow; the result is clamped as usual.
+long strtol(const char *__restrict__ nptr, char **__restrict__ endptr,
+            int base);
+long long strtoll(const char *__restrict__ nptr, char **__restrict__ endptr,
+                  int base);
+unsigned long strtoul(const char *__restrict__ nptr,
+                      char **__restrict__ endptr, int base);
+unsigned long long strtoull(const char *__restrict__ nptr,
+                            char **__restrict__ endptr, int base);
+
+// Convert a value to a string in the given base, from 2 to 36, with lower
+// case letters for digits above 9. Only base 10 shows negative values with a
+// minus sign. Returns str, which must be large enough for the result.
+char *itoa(int value, char *str, int base);
+char *utoa(unsigned value, char *str, int base);
+char *ltoa(long value, char *str, int base);
+char *ultoa(unsigned long value, char *str, int base);
+
+// Versions of the above that pad the digits with leading zeros to at least
+// width digits, not counting the sign.
+char *__itoa_pad(int value, char *str, unsigned char width, int base);
+char *__utoa_pad(unsigned value, char *str, unsigned char width, int base);
+char *__ltoa_pad(long value, char *str, unsigned char width, int base);
+char *__ultoa_pad(unsigned long value, char *str, unsigned char width,
+                  int base);
+
+// Versions of strtol and strtoul that parse directly into 8 and 16-bit types,
+// clamping to their ranges, which is cheaper than parsing a long.
+signed char __strtoi8(const char *__restrict__ nptr,
+                      char **__restrict__ endptr, int base);
+unsigned char __strtou8(const char *__restrict__ nptr,
+                        char **__restrict__ endptr, int base);
+int __strtoi16(const char *__restrict__ nptr, char **__restrict__ endptr,
+               int base);
+unsigned __strtou16(const char *__restrict__ nptr, char **__restrict__ endptr,
+                    int base);
+
 /**
 Simple malloc/free implementation.
 
@@ -126,6 +184,15 @@ size_t __heap_bytes_free();
 #define set_heap_limit __set_heap_limit
 #define heap_bytes_used __heap_bytes_used
 #define heap_bytes_free __heap_bytes_free
+#define rand8 __rand8
+#define itoa_pad __itoa_pad
+#define utoa_pad __utoa_pad
+#define ltoa_pad __ltoa_pad
+#define ultoa_pad __ultoa_pad
+#define strtoi8 __strtoi8
+#define strtou8 __strtou8
+#define strtoi16 __strtoi16
+#define strtou16 __strtou16
 
 #endif // _MOS_SOURCE
 
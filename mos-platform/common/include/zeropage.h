@@ -0,0 +1,16 @@
+#ifndef _ZEROPAGE_H_
+#define _ZEROPAGE_H_
+
+// Place a variable in the zero page. Zero page accesses are a byte shorter
+// and a cycle faster than absolute accesses, so this is best used for small,
+// frequently-accessed variables.
+//
+// The zero page region available for this is platform-specific and small; it
+// is a link error to exceed it. Zero page variables are cleared at startup,
+// like any other static variable, but they cannot have initializers: there is
+// nowhere to load the values from. An initializer on a __zeropage variable is
+// silently discarded; the variable still starts out zero. Nothing diagnoses
+// this, so don't write one.
+#define __zeropage __attribute__((section(".zp")))
+
+#endif // not _ZEROPAGE_H_
@@ -0,0 +1,239 @@
+#include <fixed.h>
+
+namespace {
+
+// The tables are computed by the compiler, so no floating point survives
+// into the library.
+
+constexpr double pi = 3.14159265358979323846;
+
+// Taylor series; converges quickly for |x| <= pi/2.
+constexpr double sin_series(double x) {
+  double term = x, sum = x;
+  for (int n = 1; n < 15; ++n) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double sqrt_newton(double x) {
+  double r = x > 1 ? x : 1;
+  for (int i = 0; i < 64; ++i)
+    r = (r + x / r) / 2;
+  return r;
+}
+
+// Halves the argument to at most tan(pi/8) before the Taylor series.
+constexpr double atan_series(double x) {
+  double h = x / (1 + sqrt_newton(1 + x * x));
+  double term = h, sum = h;
+  for (int n = 1; n < 40; ++n) {
+    term *= -h * h;
+    sum += term / (2 * n + 1);
+  }
+  return 2 * sum;
+}
+
+template <int N> struct table {
+  uint16_t v[N];
+  constexpr uint16_t operator[](int i) const { return v[i]; }
+};
+
+// sin(i/1024 turns) in 1.15, for the first quarter turn and its end.
+constexpr table<257> make_sin_table() {
+  table<257> t{};
+  for (int i = 0; i <= 256; ++i)
+    t.v[i] = (uint16_t)(sin_series(i * pi / 512) * 32768 + 0.5);
+  return t;
+}
+
+// atan(i/64) in 1/65536 turns, up to an eighth of a turn.
+constexpr table<65> make_atan_table() {
+  table<65> t{};
+  for (int i = 0; i <= 64; ++i)
+    t.v[i] = (uint16_t)(atan_series(i / 64.0) / (2 * pi) * 65536 + 0.5);
+  return t;
+}
+
+constexpr table<257> sin_table = make_sin_table();
+constexpr table<65> atan_table = make_atan_table();
+
+static_assert(sin_table[256] == 32768 && atan_table[64] == 8192,
+              "table generation is inaccurate");
+
+// sin in 1.15, of an angle in 1/65536 turns.
+uint16_t sin_abs(uint16_t angle) {
+  uint16_t i = angle & 0x3fff;
+  if (angle & 0x4000)
+    i = 0x4000 - i;
+  uint16_t index = i >> 6;
+  uint8_t frac = i & 63;
+  uint16_t s = sin_table[index];
+  if (frac)
+    s += ((sin_table[index + 1] - s) * frac + 32) >> 6;
+  return s;
+}
+
+// atan(ratio/65536) in 1/65536 turns.
+uint16_t atan_ratio(uint16_t ratio) {
+  uint8_t index = ratio >> 10;
+  uint8_t frac = (ratio >> 4) & 63;
+  uint16_t a = atan_table[index];
+  return a + (((atan_table[index + 1] - a) * frac + 32) >> 6);
+}
+
+// Extends an angle within the first octant to the octant of (x, y).
+uint16_t place_angle(uint16_t angle, bool swapped, bool x_negative,
+                     bool y_negative) {
+  if (swapped)
+    angle = 0x4000 - angle;
+  if (x_negative)
+    angle = 0x8000 - angle;
+  if (y_negative)
+    angle = -angle;
+  return angle;
+}
+
+// The square root of n, rounded to nearest, one bit at a time.
+uint32_t isqrt(uint32_t n) {
+  uint32_t result = 0, bit = (uint32_t)1 << 30;
+  while (bit > n)
+    bit >>= 2;
+  for (; bit; bit >>= 2) {
+    if (n >= result + bit) {
+      n -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+  }
+  // n is now the original n minus result squared.
+  if (n > result)
+    ++result;
+  return result;
+}
+
+} // namespace
+
+extern "C" {
+
+fix8_t fix8_mul(fix8_t a, fix8_t b) {
+  return ((int32_t)a * b + 0x80) >> 8;
+}
+
+fix16_t fix16_mul(fix16_t a, fix16_t b) {
+  return ((int64_t)a * b + 0x8000) >> 16;
+}
+
+fix8_t fix8_div(fix8_t a, fix8_t b) {
+  if (!b)
+    return a < 0 ? INT16_MIN : INT16_MAX;
+  return (int32_t)a * 256 / b;
+}
+
+fix16_t fix16_div(fix16_t a, fix16_t b) {
+  if (!b)
+    return a < 0 ? INT32_MIN : INT32_MAX;
+  return (int64_t)a * 65536 / b;
+}
+
+fix8_t fix8_sqrt(fix8_t x) {
+  if (x <= 0)
+    return 0;
+  return isqrt((uint32_t)x << 8);
+}
+
+// The square root of x * 65536 needs 48 bits, so this does the same digit
+// by digit method in two passes: first the 16 integer and 8 fractional bits
+// that the 32-bit argument determines, then the last 8 bits after shifting
+// the remainder up.
+fix16_t fix16_sqrt(fix16_t x) {
+  if (x <= 0)
+    return 0;
+  uint32_t n = x, result = 0, bit = (uint32_t)1 << 30;
+  while (bit > n)
+    bit >>= 2;
+  for (uint8_t pass = 0; pass < 2; ++pass) {
+    for (; bit; bit >>= 2) {
+      if (n >= result + bit) {
+        n -= result + bit;
+        result = (result >> 1) + bit;
+      } else {
+        result >>= 1;
+      }
+    }
+    if (pass)
+      break;
+    // result is now floor(sqrt(x)), and n is x minus its square. Continue
+    // with both scaled by 2^16, that is, result by 2^8.
+    if (n > 0xffff) {
+      // n << 16 would overflow. Since n > result, the next bit, worth 1/2,
+      // is set; take it now. The new remainder is
+      // x - (result + 1/2)^2 = n - result - 1/4, and result moves on by one
+      // bit less.
+      n -= result;
+      n = (n << 16) - 0x4000;
+      result = (result << 15) + 0x4000;
+      bit = (uint32_t)1 << 12;
+    } else {
+      n <<= 16;
+      result <<= 16;
+      bit = (uint32_t)1 << 14;
+    }
+  }
+  if (n > result)
+    ++result;
+  return result;
+}
+
+fix8_t fix8_sin(uint8_t angle) {
+  uint8_t i = angle & 0x3f;
+  if (angle & 0x40)
+    i = 0x40 - i;
+  fix8_t s = (sin_table[i * 4] + 64) >> 7;
+  return angle & 0x80 ? -s : s;
+}
+
+fix8_t fix8_cos(uint8_t angle) { return fix8_sin(angle + 0x40); }
+
+fix16_t fix16_sin(uint16_t angle) {
+  fix16_t s = (fix16_t)sin_abs(angle) << 1;
+  return angle & 0x8000 ? -s : s;
+}
+
+fix16_t fix16_cos(uint16_t angle) { return fix16_sin(angle + 0x4000); }
+
+uint8_t fix8_atan2(fix8_t y, fix8_t x) {
+  if (!x && !y)
+    return 0;
+  uint16_t ux = x < 0 ? -(uint16_t)x : x;
+  uint16_t uy = y < 0 ? -(uint16_t)y : y;
+  bool swapped = uy > ux;
+  uint16_t lo = swapped ? ux : uy, hi = swapped ? uy : ux;
+  // An 8-bit ratio is enough, and keeps the division to 16 bits.
+  while (hi > 0xff) {
+    hi >>= 1;
+    lo >>= 1;
+  }
+  uint16_t angle = lo == hi ? 0x2000 : atan_ratio((lo * 256u / hi) << 8);
+  angle = place_angle(angle, swapped, x < 0, y < 0);
+  return (angle + 0x80) >> 8;
+}
+
+uint16_t fix16_atan2(fix16_t y, fix16_t x) {
+  if (!x && !y)
+    return 0;
+  uint32_t ux = x < 0 ? -(uint32_t)x : x;
+  uint32_t uy = y < 0 ? -(uint32_t)y : y;
+  bool swapped = uy > ux;
+  uint32_t lo = swapped ? ux : uy, hi = swapped ? uy : ux;
+  while (hi > 0xffff) {
+    hi >>= 1;
+    lo >>= 1;
+  }
+  uint16_t angle = lo == hi ? 0x2000 : atan_ratio((lo << 16) / hi);
+  return place_angle(angle, swapped, x < 0, y < 0);
+}
+
+}
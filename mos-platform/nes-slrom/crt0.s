@@ -0,0 +1,29 @@
+; Put the MMC1 into a known state before anything else runs. NMIs are not yet
+; enabled, so the registers can be written directly.
+
+; Default MMC1 control register value: vertical mirroring, PRG-ROM bank mode
+; 3 (bank 15 fixed at $C000), and 8 KiB CHR-ROM banking.
+.weak __mmc1_control_init
+__mmc1_control_init = 0x0e
+
+.macro mmc1_init shadow, reg, value
+  lda #mos16lo(\value)
+  sta \shadow
+  sta \reg
+  lsr
+  sta \reg
+  lsr
+  sta \reg
+  lsr
+  sta \reg
+  lsr
+  sta \reg
+.endm
+
+.section .init.1,"axR",@progbits
+  lda #$80
+  sta $8000
+  mmc1_init __mmc1_control, $8000, __mmc1_control_init
+  mmc1_init __mmc1_chr_bank_0, $a000, 0
+  mmc1_init __mmc1_chr_bank_1, $c000, 1
+  mmc1_init __mmc1_prg_bank, $e000, 0
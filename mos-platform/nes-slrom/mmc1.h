@@ -0,0 +1,57 @@
+#ifndef _NES_SLROM_MMC1_H_
+#define _NES_SLROM_MMC1_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// MMC1 register writes. These are safe to call with NMIs enabled, even if the
+// NMI handler also writes to the MMC1: an interrupted write is retried.
+//
+// The MMC1 is always kept in PRG-ROM bank mode 3: the bank at $8000 is
+// switchable, and bank 15 is fixed at $C000. mmc1_set_control always sets the
+// PRG-ROM bank mode bits (2-3), whatever value it is given.
+void mmc1_set_control(char value);
+void mmc1_set_chr_bank_0(char bank);
+void mmc1_set_chr_bank_1(char bank);
+void mmc1_set_prg_bank(char bank);
+
+// Returns the PRG-ROM bank currently mapped at $8000.
+char mmc1_get_prg_bank(void);
+
+// Place a function or read-only object in switchable PRG-ROM bank N (0-14).
+// Such code and data are only accessible while their bank is switched in.
+#define MMC1_BANKED_CODE(n)                                                    \
+  __attribute__((section(".prg_rom_" #n ".text"), noinline))
+#define MMC1_BANKED_DATA(n) __attribute__((section(".prg_rom_" #n ".rodata")))
+
+// Define a far-call trampoline NAME in the fixed bank that switches in BANK,
+// calls TARGET with the same arguments, restores the previous bank, and
+// returns TARGET's return value. NAME must be declared with the same signature
+// as TARGET, and TARGET must have C linkage.
+//
+// For example:
+//   MMC1_BANKED_CODE(3) int load_level_impl(char n) { ... }
+//   int load_level(char n);
+//   MMC1_FAR_CALL(3, load_level, load_level_impl);
+#define MMC1_FAR_CALL(bank, name, target)                                      \
+  asm(".section .text." #name ",\"ax\",@progbits\n"                            \
+      ".global " #name "\n" #name ":\n"                                        \
+      "  tay\n"                                                                \
+      "  lda __mmc1_prg_bank\n"                                                \
+      "  pha\n"                                                                \
+      "  lda #" #bank "\n"                                                     \
+      "  jsr mmc1_set_prg_bank\n"                                              \
+      "  tya\n"                                                                \
+      "  jsr " #target "\n"                                                    \
+      "  tay\n"                                                                \
+      "  pla\n"                                                                \
+      "  jsr mmc1_set_prg_bank\n"                                              \
+      "  tya\n"                                                                \
+      "  rts\n")
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // not _NES_SLROM_MMC1_H_
@@ -0,0 +1,77 @@
+; MMC1 register interface.
+;
+; MMC1 registers are written serially, one bit per write, through a shift
+; register. If an NMI handler writes to the MMC1 in the middle of such a
+; sequence, the shift register is corrupted. To handle this, every write here
+; first resets the shift register and bumps a write counter; a write that sees
+; the counter change underneath it was interrupted by another write, and is
+; retried from the start.
+;
+; These routines clobber only A; X, Y and all imaginary registers are
+; preserved. This allows them to be used by far-call trampolines, which must
+; preserve argument and return registers.
+
+.section .noinit,"aw",@nobits
+.global __mmc1_control, __mmc1_chr_bank_0, __mmc1_chr_bank_1, __mmc1_prg_bank
+__mmc1_control:    .fill 1
+__mmc1_chr_bank_0: .fill 1
+__mmc1_chr_bank_1: .fill 1
+__mmc1_prg_bank:   .fill 1
+__mmc1_count:      .fill 1
+
+; Serially write the value in \shadow to the MMC1 register at \reg.
+.macro mmc1_write shadow, reg
+  sta \shadow
+  tya
+  pha
+1:
+  inc __mmc1_count
+  ldy __mmc1_count
+  ; Writing a value with bit 7 set resets the shift register. This also sets
+  ; PRG-ROM bank mode 3, which this platform always uses.
+  lda #$80
+  sta $8000
+  lda \shadow
+  sta \reg
+  lsr
+  sta \reg
+  lsr
+  sta \reg
+  lsr
+  sta \reg
+  lsr
+  sta \reg
+  cpy __mmc1_count
+  bne 1b
+  pla
+  tay
+  rts
+.endm
+
+.section .text.mmc1_set_control,"ax",@progbits
+.global mmc1_set_control
+mmc1_set_control:
+  ; Force PRG-ROM bank mode 3; banked code and far calls depend on it.
+  ora #$0c
+  mmc1_write __mmc1_control, $8000
+
+.section .text.mmc1_set_chr_bank_0,"ax",@progbits
+.global mmc1_set_chr_bank_0
+mmc1_set_chr_bank_0:
+  mmc1_write __mmc1_chr_bank_0, $a000
+
+.section .text.mmc1_set_chr_bank_1,"ax",@progbits
+.global mmc1_set_chr_bank_1
+mmc1_set_chr_bank_1:
+  mmc1_write __mmc1_chr_bank_1, $c000
+
+.section .text.mmc1_set_prg_bank,"ax",@progbits
+.global mmc1_set_prg_bank
+mmc1_set_prg_bank:
+  mmc1_write __mmc1_prg_bank, $e000
+
+.section .text.mmc1_get_prg_bank,"ax",@progbits
+.global mmc1_get_prg_bank
+mmc1_get_prg_bank:
+  lda __mmc1_prg_bank
+  rts
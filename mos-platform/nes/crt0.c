@@ -42,11 +42,31 @@ void __late_init(void) {
   __ppu_wait_vblank();
 }
 
-// Establish trivial nmi and irq handlers.
+// Establish a default nmi handler built from .nmi.* fragments (see
+// nmi-sections.ld). Fragments may clobber A, X, and Y; these are saved here.
+// Defining a custom nmi overrides this handler and all of its fragments.
 asm(
-  ".text\n"
-  ".weak nmi,irq\n"
+  ".section .nmi_begin,\"axR\",@progbits\n"
+  ".weak nmi\n"
   "nmi:\n"
+  "  pha\n"
+  "  txa\n"
+  "  pha\n"
+  "  tya\n"
+  "  pha\n"
+  ".section .nmi_end,\"axR\",@progbits\n"
+  "  pla\n"
+  "  tay\n"
+  "  pla\n"
+  "  tax\n"
+  "  pla\n"
+  "  rti\n"
+);
+
+// Establish a trivial irq handler.
+asm(
+  ".text\n"
+  ".weak irq\n"
   "irq:\n"
   "  rti\n"
 );
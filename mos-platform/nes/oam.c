@@ -0,0 +1,26 @@
+#include "oam.h"
+
+void oam_clear(void) { oam_hide_rest(0); }
+
+char oam_spr(char x, char y, char tile, char attr, char sprid) {
+  OAM_BUF[sprid] = y;
+  OAM_BUF[sprid + 1] = tile;
+  OAM_BUF[sprid + 2] = attr;
+  OAM_BUF[sprid + 3] = x;
+  return sprid + 4;
+}
+
+char oam_meta_spr(char x, char y, char sprid, const char *data) {
+  for (; (unsigned char)data[0] != 0x80; data += 4)
+    sprid = oam_spr(x + data[0], y + data[1], data[2], data[3], sprid);
+  return sprid;
+}
+
+void oam_hide_rest(char sprid) {
+  // Y coordinates in 0xef-0xff are below the visible area. The offset wraps
+  // around to zero after the last sprite.
+  do {
+    OAM_BUF[sprid] = 0xff;
+    sprid += 4;
+  } while (sprid);
+}
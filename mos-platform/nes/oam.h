@@ -0,0 +1,34 @@
+#ifndef _NES_OAM_H_
+#define _NES_OAM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Shadow copy of the PPU's Object Attribute Memory. Each of the 64 sprites
+// occupies 4 bytes: Y, tile, attributes, X. The default NMI handler uploads
+// the whole buffer to the PPU through OAMDMA, so sprite updates need only
+// write here.
+extern char OAM_BUF[256];
+
+// Hide all sprites by moving them below the visible area.
+void oam_clear(void);
+
+// Place a single sprite at the given byte offset into OAM_BUF. Returns the
+// offset of the next sprite slot, so that calls can be chained.
+char oam_spr(char x, char y, char tile, char attr, char sprid);
+
+// Place a metasprite at the given byte offset into OAM_BUF. The metasprite
+// data is a list of 4-byte records (x offset, y offset, tile, attributes)
+// terminated by an x offset of 0x80. Returns the offset of the next free
+// sprite slot.
+char oam_meta_spr(char x, char y, char sprid, const char *data);
+
+// Hide all sprites from the given byte offset onwards.
+void oam_hide_rest(char sprid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // not _NES_OAM_H_
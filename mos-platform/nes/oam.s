@@ -0,0 +1,23 @@
+; Shadow OAM buffer and its automatic upload during NMI.
+
+.section .oam,"aw",@nobits
+.global OAM_BUF
+OAM_BUF:
+  .fill 256
+
+; Hide all sprites before main; the contents of RAM are undefined at reset.
+.section .init.25,"axR",@progbits
+  lda #$ff
+  ldx #0
+.Lclear:
+  sta OAM_BUF,x
+  inx
+  bne .Lclear
+
+; Upload the shadow buffer to the PPU. This takes 513 or 514 cycles, and must
+; happen early in vblank.
+.section .nmi.10,"axR",@progbits
+  lda #0
+  sta _OAMADDR
+  lda #mos16hi(OAM_BUF)
+  sta _OAMDMA
@@ -37,3 +37,8 @@ PPUADDR = 0x2006
 .weak PPUDATA
 _PPUDATA = 0x2007
 PPUDATA = 0x2007
+
+.global _OAMDMA
+.weak OAMDMA
+_OAMDMA = 0x4014
+OAMDMA = 0x4014
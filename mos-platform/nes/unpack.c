@@ -0,0 +1,92 @@
+#include "unpack.h"
+#include "ppu.h"
+
+// All counts and offsets in both formats fit in 8 bits, so the inner loops
+// only ever need 8-bit index registers.
+
+char *rle_unpack(char *dst, const char *src) {
+  const char tag = *src++;
+  for (;;) {
+    char c = *src++;
+    if (c != tag) {
+      *dst++ = c;
+      continue;
+    }
+    unsigned char n = *src++;
+    if (!n)
+      return dst;
+    c = *src++;
+    do
+      *dst++ = c;
+    while (--n);
+  }
+}
+
+void rle_unpack_vram(const char *src) {
+  const char tag = *src++;
+  for (;;) {
+    char c = *src++;
+    if (c != tag) {
+      PPUDATA = c;
+      continue;
+    }
+    unsigned char n = *src++;
+    if (!n)
+      return;
+    c = *src++;
+    do
+      PPUDATA = c;
+    while (--n);
+  }
+}
+
+char *lz_unpack(char *dst, const char *src) {
+  for (;;) {
+    unsigned char token = *src++;
+    if (token < 0x80) {
+      // Literal run of token + 1 bytes.
+      unsigned char n = token + 1;
+      do
+        *dst++ = *src++;
+      while (--n);
+    } else if (token != 0xff) {
+      // Match of (token & 0x7f) + 3 bytes, at a distance of 1 to 256 bytes.
+      unsigned char n = (token & 0x7f) + 3;
+      const char *from = dst - 1 - (unsigned char)*src++;
+      do
+        *dst++ = *from++;
+      while (--n);
+    } else {
+      return dst;
+    }
+  }
+}
+
+// Window of the last 256 bytes written to PPUDATA. Only ever indexed by an
+// 8-bit position, so wraparound is free.
+__attribute__((section(".noinit"))) static char lz_window[256];
+
+void lz_unpack_vram(const char *src) {
+  unsigned char pos = 0;
+  for (;;) {
+    unsigned char token = *src++;
+    if (token < 0x80) {
+      unsigned char n = token + 1;
+      do {
+        const char c = *src++;
+        lz_window[pos++] = c;
+        PPUDATA = c;
+      } while (--n);
+    } else if (token != 0xff) {
+      unsigned char n = (token & 0x7f) + 3;
+      unsigned char from = pos - 1 - (unsigned char)*src++;
+      do {
+        const char c = lz_window[from++];
+        lz_window[pos++] = c;
+        PPUDATA = c;
+      } while (--n);
+    } else {
+      return;
+    }
+  }
+}
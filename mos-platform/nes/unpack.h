@@ -0,0 +1,30 @@
+#ifndef _NES_UNPACK_H_
+#define _NES_UNPACK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Decompressors for data produced by the host-side nes-pack tool. See
+// utils/nes-pack/nes-pack.c for the format definitions.
+//
+// The _vram variants stream their output to PPUDATA. The caller must have
+// disabled rendering (or be in vblank) and set the target address through
+// PPUADDR beforehand.
+
+// Unpack RLE data to RAM. Returns a pointer just past the last byte written.
+char *rle_unpack(char *dst, const char *src);
+// Unpack RLE data to PPUDATA.
+void rle_unpack_vram(const char *src);
+
+// Unpack LZ data to RAM. Returns a pointer just past the last byte written.
+char *lz_unpack(char *dst, const char *src);
+// Unpack LZ data to PPUDATA. Since PPU memory cannot be cheaply read back,
+// this keeps the last 256 bytes written in a RAM window.
+void lz_unpack_vram(const char *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // not _NES_UNPACK_H_
@@ -0,0 +1,10 @@
+// Establish trivial interrupt handlers for the simulator's timer. Defining a
+// custom irq or nmi overrides these.
+asm(
+  ".text\n"
+  ".weak irq\n"
+  "irq:\n"
+  ".weak nmi\n"
+  "nmi:\n"
+  "  rti\n"
+);
@@ -3,7 +3,7 @@
 #include "sim-io.h"
 
 volatile struct _sim_reg *const sim_reg_iface =
-    ((volatile struct _sim_reg *)0xFFF0);
+    ((volatile struct _sim_reg *)0xFFE0);
 
 int getchar() {
   // fetch char (may block)
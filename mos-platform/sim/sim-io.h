@@ -4,15 +4,32 @@
 #include <stdint.h>
 
 struct _sim_reg {
-  uint8_t clock[4];     // 0
-  uint8_t unclaimed;    // 4
-  char getchar;         // 5
-  char input_eof;       // 6
-  uint8_t abort;        // 7
-  int8_t exit;          // 8
-  uint8_t putchar;      // 9
+  // Programmable timer. It raises an interrupt every timer_period cycles, or
+  // once timer_period cycles after being enabled in one-shot mode.
+  uint8_t timer_period[4]; // 0
+  uint8_t timer_control;   // 4
+  uint8_t timer_status;    // 5
+  uint8_t reserved[10];    // 6
+
+  uint8_t clock[4];     // 16
+  uint8_t snapshot;     // 20
+  char getchar;         // 21
+  char input_eof;       // 22
+  uint8_t abort;        // 23
+  int8_t exit;          // 24
+  uint8_t putchar;      // 25
 };
 
+// timer_control bits. Writing timer_control with SIM_TIMER_ENABLE set
+// (re)starts the countdown.
+#define SIM_TIMER_ENABLE 0x01
+#define SIM_TIMER_NMI 0x02
+#define SIM_TIMER_ONE_SHOT 0x04
+
+// timer_status bits. The IRQ stays asserted while the timer is pending; any
+// write to timer_status acknowledges it.
+#define SIM_TIMER_PENDING 0x01
+
 extern volatile struct _sim_reg *const sim_reg_iface;
 
 #endif // _SIM_IO_H_
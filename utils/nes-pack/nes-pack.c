@@ -0,0 +1,227 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Compressor for the data formats understood by the NES platform library's
+// unpack.h. This is the reference definition of both formats.
+//
+// RLE:
+//   The first byte is a tag byte. Each following byte other than the tag is
+//   copied to the output. The tag is followed by a count N: if N is zero, the
+//   stream ends; otherwise, the next byte is repeated N times.
+//
+// LZ:
+//   A sequence of tokens T, each followed by its arguments:
+//     T < 0x80:  T+1 literal bytes follow and are copied to the output.
+//     T < 0xFF:  One byte D follows. (T & 0x7F) + 3 bytes are copied from
+//                D+1 bytes back in the output (1 to 256). The copy may
+//                overlap the bytes it produces.
+//     T == 0xFF: End of stream.
+
+static const char usage[] =
+    "Usage: nes-pack [-d] rle|lz input output\n"
+    "\n"
+    "Compresses a file for use with the NES unpack.h routines.\n"
+    "\n"
+    "OPTIONS:\n"
+    "\t-d: Decompress instead.\n";
+
+typedef struct {
+  uint8_t *data;
+  size_t size;
+  size_t capacity;
+} Buffer;
+
+static void put(Buffer *buf, uint8_t c) {
+  if (buf->size == buf->capacity) {
+    buf->capacity = buf->capacity ? buf->capacity * 2 : 4096;
+    buf->data = realloc(buf->data, buf->capacity);
+    if (!buf->data) {
+      perror("nes-pack");
+      exit(1);
+    }
+  }
+  buf->data[buf->size++] = c;
+}
+
+static void rleCompress(const uint8_t *in, size_t size, Buffer *out) {
+  // Use the least frequent byte as the tag; literal uses of it cost 3 bytes.
+  size_t counts[256] = {0};
+  for (size_t i = 0; i < size; ++i)
+    ++counts[in[i]];
+  uint8_t tag = 0;
+  for (int c = 1; c < 256; ++c)
+    if (counts[c] < counts[tag])
+      tag = c;
+  put(out, tag);
+
+  for (size_t i = 0; i < size;) {
+    size_t run = 1;
+    while (i + run < size && run < 255 && in[i + run] == in[i])
+      ++run;
+    if (run >= 4 || in[i] == tag) {
+      put(out, tag);
+      put(out, run);
+      put(out, in[i]);
+    } else {
+      for (size_t j = 0; j < run; ++j)
+        put(out, in[i]);
+    }
+    i += run;
+  }
+  put(out, tag);
+  put(out, 0);
+}
+
+static bool rleDecompress(const uint8_t *in, size_t size, Buffer *out) {
+  if (!size)
+    return false;
+  const uint8_t tag = in[0];
+  for (size_t i = 1; i < size;) {
+    if (in[i] != tag) {
+      put(out, in[i++]);
+      continue;
+    }
+    if (i + 1 >= size)
+      return false;
+    uint8_t n = in[i + 1];
+    if (!n)
+      return true;
+    if (i + 2 >= size)
+      return false;
+    while (n--)
+      put(out, in[i + 2]);
+    i += 3;
+  }
+  return false;
+}
+
+static void flushLiterals(const uint8_t *in, size_t begin, size_t end,
+                          Buffer *out) {
+  while (begin < end) {
+    size_t n = end - begin;
+    if (n > 128)
+      n = 128;
+    put(out, n - 1);
+    for (size_t i = 0; i < n; ++i)
+      put(out, in[begin + i]);
+    begin += n;
+  }
+}
+
+static void lzCompress(const uint8_t *in, size_t size, Buffer *out) {
+  size_t literalStart = 0;
+  for (size_t i = 0; i < size;) {
+    // Greedily find the longest match within the 256-byte window.
+    size_t bestLen = 0, bestDist = 0;
+    for (size_t dist = 1; dist <= 256 && dist <= i; ++dist) {
+      size_t len = 0;
+      while (len < 129 && i + len < size && in[i + len - dist] == in[i + len])
+        ++len;
+      if (len > bestLen) {
+        bestLen = len;
+        bestDist = dist;
+      }
+    }
+    if (bestLen < 3) {
+      ++i;
+      continue;
+    }
+    flushLiterals(in, literalStart, i, out);
+    put(out, 0x80 | (bestLen - 3));
+    put(out, bestDist - 1);
+    i += bestLen;
+    literalStart = i;
+  }
+  flushLiterals(in, literalStart, size, out);
+  put(out, 0xff);
+}
+
+static bool lzDecompress(const uint8_t *in, size_t size, Buffer *out) {
+  for (size_t i = 0; i < size;) {
+    uint8_t token = in[i++];
+    if (token == 0xff)
+      return true;
+    if (token < 0x80) {
+      size_t n = token + 1;
+      if (i + n > size)
+        return false;
+      for (size_t j = 0; j < n; ++j)
+        put(out, in[i++]);
+    } else {
+      if (i >= size)
+        return false;
+      size_t dist = in[i++] + 1;
+      if (dist > out->size)
+        return false;
+      for (size_t n = (token & 0x7f) + 3; n; --n)
+        put(out, out->data[out->size - dist]);
+    }
+  }
+  return false;
+}
+
+int main(int argc, const char *argv[]) {
+  bool decompress = false;
+  if (argc > 1 && !strcmp(argv[1], "-d")) {
+    decompress = true;
+    --argc;
+    ++argv;
+  }
+  if (argc != 4) {
+    fputs(usage, stderr);
+    return 1;
+  }
+
+  bool rle;
+  if (!strcmp(argv[1], "rle"))
+    rle = true;
+  else if (!strcmp(argv[1], "lz"))
+    rle = false;
+  else {
+    fputs(usage, stderr);
+    return 1;
+  }
+
+  FILE *file = fopen(argv[2], "rb");
+  if (!file) {
+    fprintf(stderr, "Could not open '%s': ", argv[2]);
+    perror(NULL);
+    return 1;
+  }
+  Buffer in = {0};
+  int c;
+  while ((c = getc(file)) != EOF)
+    put(&in, c);
+  if (ferror(file)) {
+    fprintf(stderr, "Error reading '%s': ", argv[2]);
+    perror(NULL);
+    return 1;
+  }
+  fclose(file);
+
+  Buffer out = {0};
+  if (decompress) {
+    if (!(rle ? rleDecompress : lzDecompress)(in.data, in.size, &out)) {
+      fprintf(stderr, "Malformed compressed data in '%s'.\n", argv[2]);
+      return 1;
+    }
+  } else {
+    (rle ? rleCompress : lzCompress)(in.data, in.size, &out);
+  }
+
+  file = fopen(argv[3], "wb");
+  if (!file) {
+    fprintf(stderr, "Could not open '%s': ", argv[3]);
+    perror(NULL);
+    return 1;
+  }
+  if (fwrite(out.data, 1, out.size, file) != out.size || fclose(file)) {
+    fprintf(stderr, "Error writing '%s': ", argv[3]);
+    perror(NULL);
+    return 1;
+  }
+  return 0;
+}
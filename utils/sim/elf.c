@@ -0,0 +1,323 @@
+// Minimal reader for the ELF executables produced by the llvm-mos linker.
+
+#include "elf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "symbols.h"
+
+#define PT_LOAD 1
+#define SHT_SYMTAB 2
+#define SHT_NOBITS 8
+#define SHF_WRITE 1
+#define SHF_ALLOC 2
+#define SHF_EXECINSTR 4
+#define SHN_UNDEF 0
+#define SHN_ABS 0xfff1
+#define SHN_COMMON 0xfff2
+#define STB_LOCAL 0
+#define STB_WEAK 2
+#define STT_OBJECT 1
+#define STT_SECTION 3
+#define STT_FILE 4
+
+#define EHDR_SIZE 52
+#define PHDR_SIZE 32
+#define SHDR_SIZE 40
+#define SYM_SIZE 16
+
+bool mapFile(const char *filename, struct mappedFile *f) {
+  f->data = NULL;
+  f->size = 0;
+#ifdef _WIN32
+  FILE *file = fopen(filename, "rb");
+  if (!file) {
+    fprintf(stderr, "Could not open '%s': ", filename);
+    perror(NULL);
+    return false;
+  }
+  uint8_t *data = NULL;
+  size_t capacity = 0;
+  for (;;) {
+    if (f->size == capacity) {
+      capacity = capacity ? capacity * 2 : 1 << 16;
+      data = realloc(data, capacity);
+      if (!data) {
+        perror("realloc");
+        exit(1);
+      }
+    }
+    size_t n = fread(data + f->size, 1, capacity - f->size, file);
+    f->size += n;
+    if (!n)
+      break;
+  }
+  if (ferror(file)) {
+    fprintf(stderr, "Error reading '%s': ", filename);
+    perror(NULL);
+    fclose(file);
+    free(data);
+    return false;
+  }
+  fclose(file);
+  f->data = data;
+  return true;
+#else
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "Could not open '%s': ", filename);
+    perror(NULL);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st)) {
+    fprintf(stderr, "Could not open '%s': ", filename);
+    perror(NULL);
+    close(fd);
+    return false;
+  }
+  f->size = st.st_size;
+  if (f->size) {
+    void *data = mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      fprintf(stderr, "Could not map '%s': ", filename);
+      perror(NULL);
+      close(fd);
+      return false;
+    }
+    f->data = data;
+  }
+  close(fd);
+  return true;
+#endif
+}
+
+void unmapFile(struct mappedFile *f) {
+#ifdef _WIN32
+  free((void *)f->data);
+#else
+  if (f->size)
+    munmap((void *)f->data, f->size);
+#endif
+  f->data = NULL;
+  f->size = 0;
+}
+
+static uint16_t get16(const uint8_t *p) { return p[0] | p[1] << 8; }
+static uint32_t get32(const uint8_t *p) {
+  return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+bool isElf(const struct mappedFile *f) {
+  return f->size >= 4 && !memcmp(f->data, "\177ELF", 4);
+}
+
+bool isElfFile(const char *filename) {
+  FILE *file = fopen(filename, "rb");
+  if (!file)
+    return false;
+  char magic[4];
+  bool elf = fread(magic, 4, 1, file) == 1 && !memcmp(magic, "\177ELF", 4);
+  fclose(file);
+  return elf;
+}
+
+static bool checkHeader(const struct mappedFile *f, const char *filename) {
+  const uint8_t *d = f->data;
+  // 32-bit, little-endian, version 1.
+  if (f->size < EHDR_SIZE || !isElf(f) || d[4] != 1 || d[5] != 1 ||
+      d[6] != 1) {
+    fprintf(stderr, "'%s' is not a 32-bit little-endian ELF file.\n",
+            filename);
+    return false;
+  }
+  return true;
+}
+
+// Returns the section header at the given index, or NULL if out of bounds.
+static const uint8_t *sectionHeader(const struct mappedFile *f,
+                                    uint32_t index) {
+  const uint8_t *d = f->data;
+  uint32_t shoff = get32(d + 32);
+  uint16_t shentsize = get16(d + 46), shnum = get16(d + 48);
+  if (index >= shnum || shentsize < SHDR_SIZE ||
+      shoff + (uint64_t)(index + 1) * shentsize > f->size)
+    return NULL;
+  return d + shoff + index * shentsize;
+}
+
+// Calls fn for each symbol in the symbol table, with its section header (or
+// NULL for special sections). Stops early if fn returns false.
+static bool forEachSymbol(const struct mappedFile *f, const char *filename,
+                          bool (*fn)(void *ctx, const char *name,
+                                     const uint8_t *sym, const uint8_t *shdr),
+                          void *ctx) {
+  for (uint32_t i = 0;; ++i) {
+    const uint8_t *symtab = sectionHeader(f, i);
+    if (!symtab)
+      return true;
+    if (get32(symtab + 4) != SHT_SYMTAB)
+      continue;
+    const uint8_t *strtab = sectionHeader(f, get32(symtab + 24));
+    uint32_t offset = get32(symtab + 16), size = get32(symtab + 20);
+    if (!strtab || (uint64_t)offset + size > f->size) {
+      fprintf(stderr, "'%s' has a malformed symbol table.\n", filename);
+      return false;
+    }
+    uint32_t strOffset = get32(strtab + 16), strSize = get32(strtab + 20);
+    if ((uint64_t)strOffset + strSize > f->size || !strSize ||
+        f->data[strOffset + strSize - 1]) {
+      fprintf(stderr, "'%s' has a malformed string table.\n", filename);
+      return false;
+    }
+    for (uint32_t s = 0; s + SYM_SIZE <= size; s += SYM_SIZE) {
+      const uint8_t *sym = f->data + offset + s;
+      uint32_t name = get32(sym);
+      if (name >= strSize)
+        continue;
+      uint16_t shndx = get16(sym + 14);
+      const uint8_t *shdr =
+          shndx < SHN_ABS ? sectionHeader(f, shndx) : NULL;
+      if (!fn(ctx, (const char *)f->data + strOffset + name, sym, shdr))
+        return true;
+    }
+  }
+}
+
+struct findContext {
+  const char *name;
+  uint32_t value;
+  bool found;
+};
+
+static bool findSymbolValue(void *ctx, const char *name, const uint8_t *sym,
+                            const uint8_t *shdr) {
+  struct findContext *c = ctx;
+  if (get16(sym + 14) == SHN_UNDEF || strcmp(name, c->name))
+    return true;
+  c->value = get32(sym + 4);
+  c->found = true;
+  return false;
+}
+
+static uint16_t symbolOrZero(const struct mappedFile *f, const char *filename,
+                             const char *name) {
+  struct findContext c = {name, 0, false};
+  forEachSymbol(f, filename, findSymbolValue, &c);
+  return c.found ? c.value : 0;
+}
+
+bool loadElfSegments(const struct mappedFile *f, const char *filename,
+                     uint8_t *memory) {
+  if (!checkHeader(f, filename))
+    return false;
+  const uint8_t *d = f->data;
+  uint32_t phoff = get32(d + 28);
+  uint16_t phentsize = get16(d + 42), phnum = get16(d + 44);
+  if (phnum && (phentsize < PHDR_SIZE ||
+                phoff + (uint64_t)phnum * phentsize > f->size)) {
+    fprintf(stderr, "'%s' has malformed program headers.\n", filename);
+    return false;
+  }
+
+  bool vectorsLoaded = false;
+  for (uint16_t i = 0; i < phnum; ++i) {
+    const uint8_t *ph = d + phoff + i * phentsize;
+    if (get32(ph) != PT_LOAD)
+      continue;
+    uint32_t offset = get32(ph + 4), address = get32(ph + 12);
+    uint32_t fileSize = get32(ph + 16), memSize = get32(ph + 20);
+    if (!memSize)
+      continue;
+    if (fileSize > memSize || (uint64_t)offset + fileSize > f->size) {
+      fprintf(stderr, "'%s' has a malformed segment.\n", filename);
+      return false;
+    }
+    if ((uint64_t)address + memSize > 65536) {
+      fprintf(stderr,
+              "Invalid segment: segment of %u bytes at address %u would "
+              "reach location %u, which is out of bounds.\n",
+              memSize, address, address + memSize - 1);
+      return false;
+    }
+    memcpy(&memory[address], d + offset, fileSize);
+    memset(&memory[address + fileSize], 0, memSize - fileSize);
+    if (address <= 0xfffc && address + memSize > 0xfffc)
+      vectorsLoaded = true;
+  }
+
+  if (!vectorsLoaded) {
+    uint16_t vectors[3] = {symbolOrZero(f, filename, "nmi"),
+                           (uint16_t)get32(d + 24),
+                           symbolOrZero(f, filename, "irq")};
+    for (int i = 0; i < 3; ++i) {
+      memory[0xfffa + i * 2] = vectors[i] & 0xff;
+      memory[0xfffb + i * 2] = vectors[i] >> 8;
+    }
+  }
+  return true;
+}
+
+struct addContext {
+  struct symbolTable *table;
+  const char *types;
+};
+
+// Chooses the type letter llvm-nm would show for a defined symbol.
+static char symbolType(const uint8_t *sym, const uint8_t *shdr) {
+  uint8_t bind = sym[12] >> 4, type = sym[12] & 0xf;
+  uint16_t shndx = get16(sym + 14);
+  char letter;
+  if (bind == STB_WEAK)
+    return type == STT_OBJECT ? 'V' : 'W';
+  if (shndx == SHN_ABS)
+    letter = 'A';
+  else if (shndx == SHN_COMMON)
+    letter = 'C';
+  else if (!shdr)
+    letter = '?';
+  else {
+    uint32_t shType = get32(shdr + 4), flags = get32(shdr + 8);
+    if (flags & SHF_EXECINSTR)
+      letter = 'T';
+    else if (shType == SHT_NOBITS)
+      letter = 'B';
+    else if (flags & SHF_WRITE)
+      letter = 'D';
+    else if (flags & SHF_ALLOC)
+      letter = 'R';
+    else
+      letter = 'N';
+  }
+  return bind == STB_LOCAL ? letter - 'A' + 'a' : letter;
+}
+
+static bool addElfSymbol(void *ctx, const char *name, const uint8_t *sym,
+                         const uint8_t *shdr) {
+  struct addContext *c = ctx;
+  uint8_t type = sym[12] & 0xf;
+  if (!*name || get16(sym + 14) == SHN_UNDEF || type == STT_SECTION ||
+      type == STT_FILE)
+    return true;
+  char letter = symbolType(sym, shdr);
+  if (!c->types || strchr(c->types, letter))
+    addSymbol(c->table, get32(sym + 4), get32(sym + 8), letter, name);
+  return true;
+}
+
+bool loadElfSymbols(struct symbolTable *t, const struct mappedFile *f,
+                    const char *filename, const char *types) {
+  if (!checkHeader(f, filename))
+    return false;
+  struct addContext c = {t, types};
+  return forEachSymbol(f, filename, addElfSymbol, &c);
+}
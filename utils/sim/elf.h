@@ -0,0 +1,37 @@
+#ifndef _ELF_H_
+#define _ELF_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct symbolTable;
+
+// A file mapped read-only into memory. Where mmap is unavailable, the file is
+// read into an allocated buffer instead.
+struct mappedFile {
+  const uint8_t *data;
+  size_t size;
+};
+
+bool mapFile(const char *filename, struct mappedFile *f);
+void unmapFile(struct mappedFile *f);
+
+bool isElf(const struct mappedFile *f);
+// Returns whether the named file starts with the ELF magic number.
+bool isElfFile(const char *filename);
+
+// Copies the PT_LOAD segments of a 32-bit little-endian ELF executable into
+// a 64 KiB memory to their load addresses. If no segment covers the
+// interrupt vectors, they are filled in as the sim linker script would:
+// reset with the entry point, and NMI and IRQ with the nmi and irq symbols.
+bool loadElfSegments(const struct mappedFile *f, const char *filename,
+                     uint8_t *memory);
+
+// Adds the defined symbols from the ELF symbol table, with the type letters
+// llvm-nm would show. Only types appearing in types are kept; NULL keeps all.
+// The table must be re-sorted with sortSymbols afterwards.
+bool loadElfSymbols(struct symbolTable *t, const struct mappedFile *f,
+                    const char *filename, const char *types);
+
+#endif // _ELF_H_
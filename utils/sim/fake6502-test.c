@@ -0,0 +1,545 @@
+// Conformance tests for the fake6502 core, for both the NMOS 6502 and the
+// 65C02:
+//  - The cycle count of every opcode, including the page crossing, branch and
+//    decimal mode penalties, and of interrupt entry.
+//  - ADC and SBC results and flags for every input, in binary and BCD.
+//  - A small functional test program in the style of Klaus Dormann's test
+//    suites: it traps in a loop at "fail" on the first error and at "done"
+//    after the last check. Its total cycle count is pinned as well.
+//
+// The expected values here come from the data sheets, not from fake6502's own
+// tables. Exits nonzero on any mismatch.
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fake6502.h"
+
+// Base cycle counts: untaken branches, no page crossing, binary mode.
+static const uint8_t nmosCycles[256] = {
+    /*      0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
+    /* 0 */ 7, 6, 0, 8, 3, 3, 5, 5, 3, 2, 2, 2, 4, 4, 6, 6,
+    /* 1 */ 2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    /* 2 */ 6, 6, 0, 8, 3, 3, 5, 5, 4, 2, 2, 2, 4, 4, 6, 6,
+    /* 3 */ 2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    /* 4 */ 6, 6, 0, 8, 3, 3, 5, 5, 3, 2, 2, 2, 3, 4, 6, 6,
+    /* 5 */ 2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    /* 6 */ 6, 6, 0, 8, 3, 3, 5, 5, 4, 2, 2, 2, 5, 4, 6, 6,
+    /* 7 */ 2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    /* 8 */ 2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 2, 4, 4, 4, 4,
+    /* 9 */ 2, 6, 0, 6, 4, 4, 4, 4, 2, 5, 2, 5, 5, 5, 5, 5,
+    /* A */ 2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 2, 4, 4, 4, 4,
+    /* B */ 2, 5, 0, 5, 4, 4, 4, 4, 2, 4, 2, 4, 4, 4, 4, 4,
+    /* C */ 2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6,
+    /* D */ 2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+    /* E */ 2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6,
+    /* F */ 2, 5, 0, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,
+};
+
+static const uint8_t cmosCycles[256] = {
+    /*      0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F */
+    /* 0 */ 7, 6, 2, 1, 5, 3, 5, 5, 3, 2, 2, 1, 6, 4, 6, 5,
+    /* 1 */ 2, 5, 5, 1, 5, 4, 6, 5, 2, 4, 2, 1, 6, 4, 6, 5,
+    /* 2 */ 6, 6, 2, 1, 3, 3, 5, 5, 4, 2, 2, 1, 4, 4, 6, 5,
+    /* 3 */ 2, 5, 5, 1, 4, 4, 6, 5, 2, 4, 2, 1, 4, 4, 6, 5,
+    /* 4 */ 6, 6, 2, 1, 3, 3, 5, 5, 3, 2, 2, 1, 3, 4, 6, 5,
+    /* 5 */ 2, 5, 5, 1, 4, 4, 6, 5, 2, 4, 3, 1, 8, 4, 6, 5,
+    /* 6 */ 6, 6, 2, 1, 3, 3, 5, 5, 4, 2, 2, 1, 6, 4, 6, 5,
+    /* 7 */ 2, 5, 5, 1, 4, 4, 6, 5, 2, 4, 4, 1, 6, 4, 6, 5,
+    /* 8 */ 3, 6, 2, 1, 3, 3, 3, 5, 2, 2, 2, 1, 4, 4, 4, 5,
+    /* 9 */ 2, 6, 5, 1, 4, 4, 4, 5, 2, 5, 2, 1, 4, 5, 5, 5,
+    /* A */ 2, 6, 2, 1, 3, 3, 3, 5, 2, 2, 2, 1, 4, 4, 4, 5,
+    /* B */ 2, 5, 5, 1, 4, 4, 4, 5, 2, 4, 2, 1, 4, 4, 4, 5,
+    /* C */ 2, 6, 2, 1, 3, 3, 5, 5, 2, 2, 2, 0, 4, 4, 6, 5,
+    /* D */ 2, 5, 5, 1, 4, 4, 6, 5, 2, 4, 3, 0, 4, 4, 7, 5,
+    /* E */ 2, 6, 2, 1, 3, 3, 5, 5, 2, 2, 2, 1, 4, 4, 6, 5,
+    /* F */ 2, 5, 5, 1, 4, 4, 6, 5, 2, 4, 4, 1, 4, 4, 7, 5,
+};
+// A zero above marks an opcode that is not checked: the NMOS opcodes that
+// jam the CPU, and WAI and STP, which fake6502 does not model.
+
+// Opcodes that take an extra cycle when indexing crosses a page.
+static const uint8_t nmosPageCross[] = {
+    0x11, 0x19, 0x1c, 0x1d, 0x31, 0x39, 0x3c, 0x3d, 0x51, 0x59, 0x5c,
+    0x5d, 0x71, 0x79, 0x7c, 0x7d, 0xb1, 0xb3, 0xb9, 0xbb, 0xbc, 0xbd,
+    0xbe, 0xbf, 0xd1, 0xd9, 0xdc, 0xdd, 0xf1, 0xf9, 0xfc, 0xfd,
+};
+static const uint8_t cmosPageCross[] = {
+    0x11, 0x19, 0x1d, 0x1e, 0x31, 0x39, 0x3c, 0x3d, 0x3e, 0x51,
+    0x59, 0x5d, 0x5e, 0x71, 0x79, 0x7d, 0x7e, 0xb1, 0xb9, 0xbc,
+    0xbd, 0xbe, 0xd1, 0xd9, 0xdd, 0xf1, 0xf9, 0xfd,
+};
+// Opcodes that take an extra cycle in decimal mode on the 65C02.
+static const uint8_t cmosDecimal[] = {
+    0x61, 0x65, 0x69, 0x6d, 0x71, 0x72, 0x75, 0x79, 0x7d,
+    0xe1, 0xe5, 0xe9, 0xed, 0xf1, 0xf2, 0xf5, 0xf9, 0xfd,
+};
+
+static uint8_t memory[65536];
+static struct cpu6502 cpu;
+static unsigned failures;
+
+static uint8_t readMemory(struct cpu6502 *c, uint16_t address) {
+  return memory[address];
+}
+
+static void writeMemory(struct cpu6502 *c, uint16_t address, uint8_t value) {
+  memory[address] = value;
+}
+
+// Reports a mismatch; only the first few are printed.
+static void fail(const char *mode, const char *fmt, ...) {
+  if (++failures > 50)
+    return;
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "%s: ", mode);
+  vfprintf(stderr, fmt, args);
+  fputc('\n', stderr);
+  va_end(args);
+}
+
+static void expectCycles(const char *mode, uint8_t opcode, const char *what,
+                         uint32_t expected, uint32_t actual) {
+  if (actual != expected)
+    fail(mode, "opcode %02x%s: expected %u cycles, got %u", opcode, what,
+         expected, actual);
+}
+
+static bool contains(const uint8_t *list, size_t size, uint8_t opcode) {
+  return memchr(list, opcode, size) != NULL;
+}
+
+// Resets the CPU into the given mode with all memory mapped directly.
+static void setUp(bool cmos) {
+  init6502(&cpu, readMemory, writeMemory, NULL);
+  for (int page = 0; page < 256; ++page)
+    cpu.readmap[page] = cpu.writemap[page] = &memory[page << 8];
+  reset6502(&cpu, cmos);
+}
+
+// Runs one instruction at pc and returns the cycles it took.
+static uint32_t cycles(uint16_t pc, uint8_t index, uint8_t status) {
+  cpu.pc = pc;
+  cpu.sp = 0xff;
+  cpu.a = 0;
+  cpu.x = cpu.y = index;
+  cpu.status = FLAG_CONSTANT | status;
+  uint32_t before = cpu.clockticks6502;
+  step6502(&cpu);
+  return cpu.clockticks6502 - before;
+}
+
+// Places an instruction at $0400 whose operand is zero page $F0 or absolute
+// $05F0. The zero page pointers at $F0 and $10 both point at $05F0, so every
+// addressing mode stays within a page with an index of 0 and crosses one with
+// an index of $20.
+static void placeInstruction(uint8_t opcode) {
+  memset(memory, 0, sizeof(memory));
+  memory[0x0400] = opcode;
+  memory[0x0401] = 0xf0;
+  memory[0x0402] = 0x05;
+  memory[0xf0] = memory[0x10] = 0xf0;
+  memory[0xf1] = memory[0x11] = 0x05;
+}
+
+static bool isBranch(bool cmos, uint8_t opcode) {
+  if ((opcode & 0x1f) == 0x10)
+    return true;
+  return cmos && (opcode == 0x80 || (opcode & 0x0f) == 0x0f);
+}
+
+// Places a branch at pc to pc+$10 past its end, with the flags or zero page
+// bit set up to take it or not. Returns the status to run it with.
+static uint8_t placeBranch(uint8_t opcode, uint16_t pc, bool taken) {
+  memset(memory, 0, sizeof(memory));
+  memory[pc] = opcode;
+  if ((opcode & 0x0f) == 0x0f) {
+    // BBRn/BBSn $F0: branch if bit n is clear/set.
+    bool set = opcode & 0x80;
+    memory[pc + 1] = 0xf0;
+    memory[pc + 2] = 0x10;
+    memory[0xf0] = set == taken ? 1 << (opcode >> 4 & 7) : 0;
+    return 0;
+  }
+  memory[pc + 1] = 0x10;
+  if (opcode == 0x80)
+    return 0;
+  // Bits 7-6 select N, V, C or Z; bit 5 is the value that takes the branch.
+  static const uint8_t flags[4] = {FLAG_SIGN, FLAG_OVERFLOW, FLAG_CARRY,
+                                   FLAG_ZERO};
+  bool set = opcode & 0x20;
+  return set == taken ? flags[opcode >> 6] : 0;
+}
+
+static void testTiming(bool cmos) {
+  const char *mode = cmos ? "65C02" : "NMOS";
+  const uint8_t *table = cmos ? cmosCycles : nmosCycles;
+  const uint8_t *pageCross = cmos ? cmosPageCross : nmosPageCross;
+  size_t pageCrossSize = cmos ? sizeof(cmosPageCross) : sizeof(nmosPageCross);
+  setUp(cmos);
+
+  for (int opcode = 0; opcode < 256; ++opcode) {
+    uint32_t base = table[opcode];
+    if (!base)
+      continue;
+
+    if (isBranch(cmos, opcode)) {
+      // BRA is always taken; its base count includes that.
+      bool bra = opcode == 0x80;
+      uint32_t taken = bra ? base : base + 1;
+      uint8_t status;
+      if (!bra) {
+        status = placeBranch(opcode, 0x0400, false);
+        expectCycles(mode, opcode, " untaken", base, cycles(0x0400, 0, status));
+      }
+      status = placeBranch(opcode, 0x0400, true);
+      expectCycles(mode, opcode, " taken", taken, cycles(0x0400, 0, status));
+      status = placeBranch(opcode, 0x04f0, true);
+      expectCycles(mode, opcode, " taken across a page", taken + 1,
+                   cycles(0x04f0, 0, status));
+      continue;
+    }
+
+    placeInstruction(opcode);
+    expectCycles(mode, opcode, "", base, cycles(0x0400, 0, 0));
+
+    placeInstruction(opcode);
+    expectCycles(mode, opcode, " across a page",
+                 base + contains(pageCross, pageCrossSize, opcode),
+                 cycles(0x0400, 0x20, 0));
+
+    placeInstruction(opcode);
+    expectCycles(mode, opcode, " in decimal mode",
+                 base + (cmos &&
+                         contains(cmosDecimal, sizeof(cmosDecimal), opcode)),
+                 cycles(0x0400, 0, FLAG_DECIMAL));
+  }
+
+  // Interrupt entry takes 7 cycles and on the 65C02 leaves decimal mode. Only
+  // BRK pushes the status with B set; it also skips a padding byte.
+  static const char *const entries[] = {"IRQ", "NMI", "BRK"};
+  for (int entry = 0; entry < 3; ++entry) {
+    bool nmi = entry == 1, brk = entry == 2;
+    memset(memory, 0, sizeof(memory));
+    memory[nmi ? 0xfffa : 0xfffe] = 0x34;
+    memory[nmi ? 0xfffb : 0xffff] = 0x12;
+    cpu.pc = 0x0400;
+    cpu.sp = 0xff;
+    cpu.status = FLAG_CONSTANT | FLAG_DECIMAL;
+    uint32_t before = cpu.clockticks6502;
+    if (brk)
+      step6502(&cpu);
+    else if (nmi)
+      nmi6502(&cpu);
+    else
+      irq6502(&cpu);
+    uint32_t actual = cpu.clockticks6502 - before;
+    uint16_t pushedPc = memory[0x01ff] << 8 | memory[0x01fe];
+    uint8_t pushed = memory[0x01fd];
+    if (actual != 7 || cpu.pc != 0x1234 || pushedPc != (brk ? 0x0402 : 0x0400) ||
+        !(pushed & FLAG_BREAK) != !brk || !(pushed & FLAG_DECIMAL) ||
+        !(cpu.status & FLAG_INTERRUPT) || !(cpu.status & FLAG_DECIMAL) != cmos)
+      fail(mode,
+           "%s entry: %u cycles, pc %04x, pushed pc %04x and status %02x, "
+           "status %02x",
+           entries[entry], actual, cpu.pc, pushedPc, pushed, cpu.status);
+  }
+}
+
+static bool isBcd(unsigned v) { return (v & 0x0f) < 10 && v >> 4 < 10; }
+
+// Reference ADC and SBC. For BCD, the results are only defined for valid BCD
+// inputs; on the NMOS part only A and C are.
+static unsigned binaryAdd(unsigned a, unsigned b, unsigned carry,
+                          uint8_t *flags) {
+  unsigned sum = a + b + carry;
+  *flags = (sum > 0xff ? FLAG_CARRY : 0) |
+           ((~(a ^ b) & (a ^ sum) & 0x80) ? FLAG_OVERFLOW : 0);
+  return sum & 0xff;
+}
+
+static unsigned decimalAdd(unsigned a, unsigned b, unsigned carry,
+                           bool *carryOut) {
+  int lo = (a & 0x0f) + (b & 0x0f) + carry;
+  if (lo >= 0x0a)
+    lo = ((lo + 0x06) & 0x0f) + 0x10;
+  int sum = (a & 0xf0) + (b & 0xf0) + lo;
+  if (sum >= 0xa0)
+    sum += 0x60;
+  *carryOut = sum >= 0x100;
+  return sum & 0xff;
+}
+
+static unsigned decimalSubtract(unsigned a, unsigned b, unsigned carry,
+                                bool *carryOut) {
+  int lo = (a & 0x0f) - (b & 0x0f) + (int)carry - 1;
+  if (lo < 0)
+    lo = ((lo - 0x06) & 0x0f) - 0x10;
+  int diff = (a & 0xf0) - (b & 0xf0) + lo;
+  if (diff < 0)
+    diff -= 0x60;
+  *carryOut = (int)a - (int)b + (int)carry - 1 >= 0;
+  return diff & 0xff;
+}
+
+static void testArithmetic(bool cmos) {
+  const char *mode = cmos ? "65C02" : "NMOS";
+  setUp(cmos);
+  memset(memory, 0, sizeof(memory));
+  for (int sbc = 0; sbc < 2; ++sbc) {
+    for (int decimal = 0; decimal < 2; ++decimal) {
+      for (unsigned a = 0; a < 256; ++a) {
+        for (unsigned b = 0; b < 256; ++b) {
+          if (decimal && !(isBcd(a) && isBcd(b)))
+            continue;
+          for (unsigned carry = 0; carry < 2; ++carry) {
+            memory[0x0400] = sbc ? 0xe9 : 0x69;
+            memory[0x0401] = b;
+            cpu.pc = 0x0400;
+            cpu.a = a;
+            cpu.status =
+                FLAG_CONSTANT | carry | (decimal ? FLAG_DECIMAL : 0);
+            step6502(&cpu);
+
+            uint8_t mask = FLAG_CARRY, flags;
+            unsigned result;
+            if (decimal) {
+              bool carryOut;
+              result = sbc ? decimalSubtract(a, b, carry, &carryOut)
+                           : decimalAdd(a, b, carry, &carryOut);
+              flags = carryOut ? FLAG_CARRY : 0;
+              if (cmos)
+                mask |= FLAG_ZERO | FLAG_SIGN;
+            } else {
+              result = binaryAdd(a, sbc ? b ^ 0xff : b, carry, &flags);
+              mask |= FLAG_ZERO | FLAG_SIGN | FLAG_OVERFLOW;
+            }
+            flags |= (result ? 0 : FLAG_ZERO) | (result & FLAG_SIGN);
+            if (cpu.a != result || (cpu.status & mask) != (flags & mask))
+              fail(mode,
+                   "%s%s %02x, %02x, carry %u: expected %02x, status %02x; "
+                   "got %02x, status %02x",
+                   decimal ? "decimal " : "", sbc ? "SBC" : "ADC", a, b, carry,
+                   result, flags & mask, cpu.a, cpu.status & mask);
+          }
+        }
+      }
+    }
+  }
+}
+
+// The functional test program. The listing gives each instruction's address.
+static const uint8_t program[] = {
+    0xa2, 0xff,       // 0400 start:  ldx #$ff
+    0x9a,             // 0402         txs
+    0xd8,             // 0403         cld
+    0xa9, 0xfe,       // 0404         lda #<brkh
+    0x8d, 0xfe, 0xff, // 0406         sta $fffe
+    0xa9, 0x04,       // 0409         lda #>brkh
+    0x8d, 0xff, 0xff, // 040b         sta $ffff
+    // 1: JSR/RTS preserve the stack; PHA/PLA round trip
+    0xa9, 0x55,       // 040e         lda #$55
+    0x20, 0xf9, 0x04, // 0410         jsr sub1
+    0xc9, 0x55,       // 0413         cmp #$55
+    0xd0, 0x45,       // 0415         bne fail1
+    0xba,             // 0417         tsx
+    0xe0, 0xff,       // 0418         cpx #$ff
+    0xd0, 0x40,       // 041a         bne fail1
+    // 2: PHP/PLP restore N, Z and C
+    0xa9, 0xff,       // 041c         lda #$ff
+    0x38,             // 041e         sec
+    0x08,             // 041f         php
+    0x18,             // 0420         clc
+    0xa9, 0x00,       // 0421         lda #0
+    0x28,             // 0423         plp
+    0x90, 0x36,       // 0424         bcc fail1
+    0x10, 0x34,       // 0426         bpl fail1
+    0xf0, 0x32,       // 0428         beq fail1
+    // 3: BRK skips its padding byte, pushes B set, and returns via RTI
+    0xa9, 0x00,       // 042a         lda #0
+    0x85, 0x00,       // 042c         sta $00
+    0x00,             // 042e         brk
+    0xea,             // 042f         .byte $ea
+    0xa5, 0x00,       // 0430         lda $00
+    0xc9, 0x01,       // 0432         cmp #1
+    0xd0, 0x26,       // 0434         bne fail1
+    // 4: 16-bit sum of 1..100 is 5050
+    0xa9, 0x00,       // 0436         lda #0
+    0x85, 0x01,       // 0438         sta $01
+    0x85, 0x02,       // 043a         sta $02
+    0xa2, 0x64,       // 043c         ldx #100
+    0x8a,             // 043e sum:    txa
+    0x18,             // 043f         clc
+    0x65, 0x01,       // 0440         adc $01
+    0x85, 0x01,       // 0442         sta $01
+    0xa5, 0x02,       // 0444         lda $02
+    0x69, 0x00,       // 0446         adc #0
+    0x85, 0x02,       // 0448         sta $02
+    0xca,             // 044a         dex
+    0xd0, 0xf1,       // 044b         bne sum
+    0xa5, 0x01,       // 044d         lda $01
+    0xc9, 0xba,       // 044f         cmp #$ba
+    0xd0, 0x09,       // 0451         bne fail1
+    0xa5, 0x02,       // 0453         lda $02
+    0xc9, 0x13,       // 0455         cmp #$13
+    0xd0, 0x03,       // 0457         bne fail1
+    0x4c, 0x5f, 0x04, // 0459         jmp t5
+    0x4c, 0xf6, 0x04, // 045c fail1:  jmp fail
+    // 5: zero page indexing wraps around
+    0xa9, 0x77,       // 045f t5:     lda #$77
+    0x85, 0x05,       // 0461         sta $05
+    0xa2, 0x10,       // 0463         ldx #$10
+    0xb5, 0xf5,       // 0465         lda $f5,x
+    0xc9, 0x77,       // 0467         cmp #$77
+    0xd0, 0x63,       // 0469         bne fail2
+    // 6: (zp),Y and (zp,X)
+    0xa9, 0x80,       // 046b         lda #$80
+    0x85, 0x06,       // 046d         sta $06
+    0xa9, 0x02,       // 046f         lda #$02
+    0x85, 0x07,       // 0471         sta $07
+    0xa9, 0x99,       // 0473         lda #$99
+    0x8d, 0x90, 0x02, // 0475         sta $0290
+    0xa9, 0x42,       // 0478         lda #$42
+    0x8d, 0x80, 0x02, // 047a         sta $0280
+    0xa0, 0x10,       // 047d         ldy #$10
+    0xb1, 0x06,       // 047f         lda ($06),y
+    0xc9, 0x99,       // 0481         cmp #$99
+    0xd0, 0x49,       // 0483         bne fail2
+    0xa2, 0x02,       // 0485         ldx #$02
+    0xa1, 0x04,       // 0487         lda ($04,x)
+    0xc9, 0x42,       // 0489         cmp #$42
+    0xd0, 0x41,       // 048b         bne fail2
+    // 7: multi-byte shifts carry between bytes
+    0xa9, 0x81,       // 048d         lda #$81
+    0x85, 0x08,       // 048f         sta $08
+    0xa9, 0x01,       // 0491         lda #$01
+    0x85, 0x09,       // 0493         sta $09
+    0x06, 0x08,       // 0495         asl $08
+    0x26, 0x09,       // 0497         rol $09
+    0xb0, 0x33,       // 0499         bcs fail2
+    0xa5, 0x08,       // 049b         lda $08
+    0xc9, 0x02,       // 049d         cmp #$02
+    0xd0, 0x2d,       // 049f         bne fail2
+    0xa5, 0x09,       // 04a1         lda $09
+    0xc9, 0x03,       // 04a3         cmp #$03
+    0xd0, 0x27,       // 04a5         bne fail2
+    0x46, 0x09,       // 04a7         lsr $09
+    0x66, 0x08,       // 04a9         ror $08
+    0xb0, 0x21,       // 04ab         bcs fail2
+    0xa5, 0x08,       // 04ad         lda $08
+    0xc9, 0x81,       // 04af         cmp #$81
+    0xd0, 0x1b,       // 04b1         bne fail2
+    // 8: BCD addition and subtraction
+    0xf8,             // 04b3         sed
+    0x18,             // 04b4         clc
+    0xa9, 0x19,       // 04b5         lda #$19
+    0x69, 0x01,       // 04b7         adc #$01
+    0xd8,             // 04b9         cld
+    0xc9, 0x20,       // 04ba         cmp #$20
+    0xd0, 0x10,       // 04bc         bne fail2
+    0xf8,             // 04be         sed
+    0x38,             // 04bf         sec
+    0xa9, 0x00,       // 04c0         lda #$00
+    0xe9, 0x01,       // 04c2         sbc #$01
+    0xd8,             // 04c4         cld
+    0xb0, 0x07,       // 04c5         bcs fail2
+    0xc9, 0x99,       // 04c7         cmp #$99
+    0xd0, 0x03,       // 04c9         bne fail2
+    0x4c, 0xd1, 0x04, // 04cb         jmp t9
+    0x4c, 0xf6, 0x04, // 04ce fail2:  jmp fail
+    // 9: JMP ($02FF) takes its high byte from $0200 on the NMOS part (which
+    // lands at $0600) and from $0300 on the 65C02 (which lands at $0700). $0B
+    // holds the expected mode.
+    0xa9, 0x00,       // 04d1 t9:     lda #$00
+    0x8d, 0xff, 0x02, // 04d3         sta $02ff
+    0xa9, 0x06,       // 04d6         lda #$06
+    0x8d, 0x00, 0x02, // 04d8         sta $0200
+    0xa9, 0x07,       // 04db         lda #$07
+    0x8d, 0x00, 0x03, // 04dd         sta $0300
+    0x6c, 0xff, 0x02, // 04e0         jmp ($02ff)
+    0xa5, 0x0a,       // 04e3 back:   lda $0a
+    0xc5, 0x0b,       // 04e5         cmp $0b
+    0xd0, 0x0d,       // 04e7         bne fail
+    // 10: overflow from signed addition; CLV clears it
+    0x18,             // 04e9         clc
+    0xa9, 0x7f,       // 04ea         lda #$7f
+    0x69, 0x01,       // 04ec         adc #$01
+    0x50, 0x06,       // 04ee         bvc fail
+    0xb8,             // 04f0         clv
+    0x70, 0x03,       // 04f1         bvs fail
+    0x4c, 0xf3, 0x04, // 04f3 done:   jmp done
+    0x4c, 0xf6, 0x04, // 04f6 fail:   jmp fail
+
+    0x48,             // 04f9 sub1:   pha
+    0xa9, 0xaa,       // 04fa         lda #$aa
+    0x68,             // 04fc         pla
+    0x60,             // 04fd         rts
+
+    // The pushed status must have B set.
+    0x68,             // 04fe brkh:   pla
+    0x48,             // 04ff         pha
+    0x29, 0x10,       // 0500         and #$10
+    0xf0, 0xf2,       // 0502         beq fail
+    0xe6, 0x00,       // 0504         inc $00
+    0x40,             // 0506         rti
+};
+static const uint8_t nmosTarget[] = {
+    0xa9, 0x01,       // 0600         lda #1
+    0x85, 0x0a,       // 0602         sta $0a
+    0x4c, 0xe3, 0x04, // 0604         jmp back
+};
+static const uint8_t cmosTarget[] = {
+    0xa9, 0x02,       // 0700         lda #2
+    0x85, 0x0a,       // 0702         sta $0a
+    0x4c, 0xe3, 0x04, // 0704         jmp back
+};
+#define PROGRAM_DONE 0x04f3
+
+// Total cycles to reach "done".
+static const uint32_t programCycles[2] = {2638, 2641};
+
+static void testProgram(bool cmos) {
+  const char *mode = cmos ? "65C02" : "NMOS";
+  memset(memory, 0, sizeof(memory));
+  memcpy(&memory[0x0400], program, sizeof(program));
+  memcpy(&memory[0x0600], nmosTarget, sizeof(nmosTarget));
+  memcpy(&memory[0x0700], cmosTarget, sizeof(cmosTarget));
+  memory[0x0b] = cmos ? 2 : 1;
+  memory[0xfffc] = 0x00;
+  memory[0xfffd] = 0x04;
+  setUp(cmos);
+
+  // Run until the program traps in a jump to itself.
+  for (uint32_t i = 0; i < 100000; ++i) {
+    uint16_t pc = cpu.pc;
+    step6502(&cpu);
+    if (cpu.pc == pc) {
+      // The trap's own jump is not part of the program.
+      uint32_t total = cpu.clockticks6502 - 3;
+      if (pc != PROGRAM_DONE)
+        fail(mode, "program failed at %04x", pc);
+      else if (total != programCycles[cmos])
+        fail(mode, "program took %u cycles, expected %u", total,
+             programCycles[cmos]);
+      return;
+    }
+  }
+  fail(mode, "program did not finish");
+}
+
+int main(void) {
+  for (int cmos = 0; cmos < 2; ++cmos) {
+    testTiming(cmos);
+    testArithmetic(cmos);
+    testProgram(cmos);
+  }
+  if (failures) {
+    fprintf(stderr, "%u failures\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -55,17 +55,17 @@ limitations under the License.
  *****************************************************
  * Usage:                                            *
  *                                                   *
- * Fake6502 requires you to provide two external     *
- * functions:                                        *
- *                                                   *
- * uint8_t read6502(uint16_t address)                *
- * void write6502(uint16_t address, uint8_t value)   *
+ * All CPU state lives in a struct cpu6502 (see      *
+ * fake6502.h), which is passed to every function    *
+ * below. Memory is accessed through the per-page    *
+ * readmap/writemap pointers where they are set, and *
+ * through the read/write callbacks given to         *
+ * init6502 everywhere else.                         *
  *                                                   *
  * You may optionally pass Fake6502 the pointer to a *
  * function which you want to be called after every  *
  * emulated instruction. This function should be a   *
- * void with no parameters expected to be passed to  *
- * it.                                               *
+ * void taking the struct cpu6502 pointer.           *
  *                                                   *
  * This can be very useful. For example, in a NES    *
  * emulator, you check the number of clock ticks     *
@@ -73,38 +73,43 @@ limitations under the License.
  * APU events.                                       *
  *                                                   *
  * To pass Fake6502 this pointer, use the            *
- * hookexternal(void *funcptr) function provided.    *
+ * hookexternal(c, funcptr) function provided.       *
  *                                                   *
  * To disable the hook later, pass NULL to it.       *
  *****************************************************
  * Useful functions in this emulator:                *
  *                                                   *
- * void reset6502(uint8_t cmos)                      *
+ * void init6502(c, read, write, user)               *
+ *   - Clear a context and install the memory access *
+ *     callbacks. Call this before anything else.    *
+ *                                                   *
+ * void reset6502(c, uint8_t cmos)                   *
  *   - Call this once before you begin execution.    *
  *   - 65C02 emulation is enabled by setting the     *
  *     cmos flag.                                    *
  *                                                   *
- * void exec6502(uint32_t tickcount)                 *
+ * void exec6502(c, uint32_t tickcount)              *
  *   - Execute 6502 code up to the next specified    *
  *     count of clock ticks.                         *
  *                                                   *
- * void step6502()                                   *
+ * void step6502(c)                                  *
  *   - Execute a single instrution.                  *
  *                                                   *
- * void irq6502()                                    *
- *   - Trigger a hardware IRQ in the 6502 core.      *
+ * void irq6502(c)                                   *
+ *   - Trigger a hardware IRQ in the 6502 core. The  *
+ *     caller checks the interrupt disable flag.     *
  *                                                   *
- * void nmi6502()                                    *
+ * void nmi6502(c)                                   *
  *   - Trigger an NMI in the 6502 core.              *
  *                                                   *
- * void hookexternal(void *funcptr)                  *
- *   - Pass a pointer to a void function taking no   *
- *     parameters. This will cause Fake6502 to call  *
+ * void hookexternal(c, funcptr)                     *
+ *   - Pass a pointer to a void function taking the  *
+ *     CPU context. This will cause Fake6502 to call *
  *     that function once after each emulated        *
  *     instruction.                                  *
  *                                                   *
  *****************************************************
- * Useful variables in this emulator:                *
+ * Useful fields of struct cpu6502:                  *
  *                                                   *
  * uint32_t clockticks6502                           *
  *   - A running total of the emulated cycle count.  *
@@ -118,6 +123,9 @@ limitations under the License.
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+
+#include "fake6502.h"
 
 //6502 defines
 #define UNDOCUMENTED //when this is defined, undocumented opcodes are handled.
@@ -128,33 +136,24 @@ limitations under the License.
                      //CPU in the Nintendo Entertainment System does not
                      //support BCD operation.
 
-#define FLAG_CARRY     0x01
-#define FLAG_ZERO      0x02
-#define FLAG_INTERRUPT 0x04
-#define FLAG_DECIMAL   0x08
-#define FLAG_BREAK     0x10
-#define FLAG_CONSTANT  0x20
-#define FLAG_OVERFLOW  0x40
-#define FLAG_SIGN      0x80
-
 #define BASE_STACK     0x100
 
-#define saveaccum(n) a = (uint8_t)((n) & 0x00FF)
+#define saveaccum(n) c->a = (uint8_t)((n) & 0x00FF)
 
 
 //flag modifier macros
-#define setcarry() (status |= FLAG_CARRY)
-#define clearcarry() (status &= ~FLAG_CARRY)
-#define setzero() (status |= FLAG_ZERO)
-#define clearzero() (status &= ~FLAG_ZERO)
-#define setinterrupt() (status |= FLAG_INTERRUPT)
-#define clearinterrupt() (status &= ~FLAG_INTERRUPT)
-#define setdecimal() (status |= FLAG_DECIMAL)
-#define cleardecimal() (status &= ~FLAG_DECIMAL)
-#define setoverflow() (status |= FLAG_OVERFLOW)
-#define clearoverflow() (status &= ~FLAG_OVERFLOW)
-#define setsign() (status |= FLAG_SIGN)
-#define clearsign() (status &= ~FLAG_SIGN)
+#define setcarry() (c->status |= FLAG_CARRY)
+#define clearcarry() (c->status &= ~FLAG_CARRY)
+#define setzero() (c->status |= FLAG_ZERO)
+#define clearzero() (c->status &= ~FLAG_ZERO)
+#define setinterrupt() (c->status |= FLAG_INTERRUPT)
+#define clearinterrupt() (c->status &= ~FLAG_INTERRUPT)
+#define setdecimal() (c->status |= FLAG_DECIMAL)
+#define cleardecimal() (c->status &= ~FLAG_DECIMAL)
+#define setoverflow() (c->status |= FLAG_OVERFLOW)
+#define clearoverflow() (c->status &= ~FLAG_OVERFLOW)
+#define setsign() (c->status |= FLAG_SIGN)
+#define clearsign() (c->status &= ~FLAG_SIGN)
 
 
 //flag calculation macros
@@ -179,668 +178,685 @@ limitations under the License.
 }
 
 
-//6502 CPU registers
-uint16_t pc;
-uint8_t sp, a, x, y, status;
-
-
-//helper variables
-uint32_t instructions = 0; //keep track of total instructions executed
-uint32_t clockticks6502 = 0, clockgoal6502 = 0;
-uint16_t oldpc, ea, reladdr, value, result;
-uint8_t opcode, oldstatus;
+//memory access, through the page maps when possible
+static inline uint8_t read6502(struct cpu6502 *c, uint16_t address) {
+    const uint8_t *page = c->readmap[address >> 8];
+    if (page) return page[address & 0xFF];
+    return c->read(c, address);
+}
 
-//externally supplied functions
-extern uint8_t read6502(uint16_t address);
-extern void write6502(uint16_t address, uint8_t value);
+static inline void write6502(struct cpu6502 *c, uint16_t address, uint8_t value) {
+    uint8_t *page = c->writemap[address >> 8];
+    if (page) page[address & 0xFF] = value;
+        else c->write(c, address, value);
+}
 
 //a few general functions used by various other functions
-void push16(uint16_t pushval) {
-    write6502(BASE_STACK + sp, (pushval >> 8) & 0xFF);
-    write6502(BASE_STACK + ((sp - 1) & 0xFF), pushval & 0xFF);
-    sp -= 2;
+static void push16(struct cpu6502 *c, uint16_t pushval) {
+    write6502(c, BASE_STACK + c->sp, (pushval >> 8) & 0xFF);
+    write6502(c, BASE_STACK + ((c->sp - 1) & 0xFF), pushval & 0xFF);
+    c->sp -= 2;
 }
 
-void push8(uint8_t pushval) {
-    write6502(BASE_STACK + sp--, pushval);
+static void push8(struct cpu6502 *c, uint8_t pushval) {
+    write6502(c, BASE_STACK + c->sp--, pushval);
 }
 
-uint16_t pull16() {
+static uint16_t pull16(struct cpu6502 *c) {
     uint16_t temp16;
-    temp16 = read6502(BASE_STACK + ((sp + 1) & 0xFF)) | ((uint16_t)read6502(BASE_STACK + ((sp + 2) & 0xFF)) << 8);
-    sp += 2;
+    temp16 = read6502(c, BASE_STACK + ((c->sp + 1) & 0xFF)) | ((uint16_t)read6502(c, BASE_STACK + ((c->sp + 2) & 0xFF)) << 8);
+    c->sp += 2;
     return(temp16);
 }
 
-uint8_t pull8() {
-    return (read6502(BASE_STACK + ++sp));
+static uint8_t pull8(struct cpu6502 *c) {
+    return (read6502(c, BASE_STACK + ++c->sp));
 }
 
 
-static void (**addrtable)() = NULL;
-static void (**optable)() = NULL;
-static const uint32_t *ticktable = NULL;
-uint8_t penaltyop, penaltyaddr;
-
 //addressing mode functions, calculates effective addresses
-static void imp() { //implied
+static void imp(struct cpu6502 *c) { //implied
 }
 
-static void acc() { //accumulator
+static void acc(struct cpu6502 *c) { //accumulator
 }
 
-static void imm() { //immediate
-    ea = pc++;
+static void imm(struct cpu6502 *c) { //immediate
+    c->ea = c->pc++;
 }
 
-static void zp() { //zero-page
-    ea = (uint16_t)read6502((uint16_t)pc++);
+static void zp(struct cpu6502 *c) { //zero-page
+    c->ea = (uint16_t)read6502(c, (uint16_t)c->pc++);
 }
 
-static void zpx() { //zero-page,X
-    ea = ((uint16_t)read6502((uint16_t)pc++) + (uint16_t)x) & 0xFF; //zero-page wraparound
+static void zpx(struct cpu6502 *c) { //zero-page,X
+    c->ea = ((uint16_t)read6502(c, (uint16_t)c->pc++) + (uint16_t)c->x) & 0xFF; //zero-page wraparound
 }
 
-static void zpy() { //zero-page,Y
-    ea = ((uint16_t)read6502((uint16_t)pc++) + (uint16_t)y) & 0xFF; //zero-page wraparound
+static void zpy(struct cpu6502 *c) { //zero-page,Y
+    c->ea = ((uint16_t)read6502(c, (uint16_t)c->pc++) + (uint16_t)c->y) & 0xFF; //zero-page wraparound
 }
 
-static void rel() { //relative for branch ops (8-bit immediate value, sign-extended)
-    reladdr = (uint16_t)read6502(pc++);
-    if (reladdr & 0x80) reladdr |= 0xFF00;
+static void rel(struct cpu6502 *c) { //relative for branch ops (8-bit immediate value, sign-extended)
+    c->reladdr = (uint16_t)read6502(c, c->pc++);
+    if (c->reladdr & 0x80) c->reladdr |= 0xFF00;
 }
 
-static void zpr() { //combined zp, rel for bbr/bbs
-    ea = (uint16_t)read6502((uint16_t)pc++);
-    reladdr = (uint16_t)read6502(pc++);
-    if (reladdr & 0x80) reladdr |= 0xFF00;
+static void zpr(struct cpu6502 *c) { //combined zp, rel for bbr/bbs
+    c->ea = (uint16_t)read6502(c, (uint16_t)c->pc++);
+    c->reladdr = (uint16_t)read6502(c, c->pc++);
+    if (c->reladdr & 0x80) c->reladdr |= 0xFF00;
 }
 
-static void abso() { //absolute
-    ea = (uint16_t)read6502(pc) | ((uint16_t)read6502(pc+1) << 8);
-    pc += 2;
+static void abso(struct cpu6502 *c) { //absolute
+    c->ea = (uint16_t)read6502(c, c->pc) | ((uint16_t)read6502(c, c->pc+1) << 8);
+    c->pc += 2;
 }
 
-static void absx() { //absolute,X
+static void absx(struct cpu6502 *c) { //absolute,X
     uint16_t startpage;
-    ea = ((uint16_t)read6502(pc) | ((uint16_t)read6502(pc+1) << 8));
-    startpage = ea & 0xFF00;
-    ea += (uint16_t)x;
+    c->ea = ((uint16_t)read6502(c, c->pc) | ((uint16_t)read6502(c, c->pc+1) << 8));
+    startpage = c->ea & 0xFF00;
+    c->ea += (uint16_t)c->x;
 
-    if (startpage != (ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
-        penaltyaddr = 1;
+    if (startpage != (c->ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
+        c->penaltyaddr = 1;
     }
 
-    pc += 2;
+    c->pc += 2;
 }
 
-static void absy() { //absolute,Y
+static void absy(struct cpu6502 *c) { //absolute,Y
     uint16_t startpage;
-    ea = ((uint16_t)read6502(pc) | ((uint16_t)read6502(pc+1) << 8));
-    startpage = ea & 0xFF00;
-    ea += (uint16_t)y;
+    c->ea = ((uint16_t)read6502(c, c->pc) | ((uint16_t)read6502(c, c->pc+1) << 8));
+    startpage = c->ea & 0xFF00;
+    c->ea += (uint16_t)c->y;
 
-    if (startpage != (ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
-        penaltyaddr = 1;
+    if (startpage != (c->ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
+        c->penaltyaddr = 1;
     }
 
-    pc += 2;
+    c->pc += 2;
 }
 
-static void ind() { //indirect
+static void ind(struct cpu6502 *c) { //indirect
     uint16_t eahelp, eahelp2;
-    eahelp = (uint16_t)read6502(pc) | (uint16_t)((uint16_t)read6502(pc+1) << 8);
-    eahelp2 = (eahelp & 0xFF00) | ((eahelp + 1) & 0x00FF); //replicate 6502 page-boundary wraparound bug
-    ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
-    pc += 2;
+    eahelp = (uint16_t)read6502(c, c->pc) | (uint16_t)((uint16_t)read6502(c, c->pc+1) << 8);
+    if (c->cmos)
+        eahelp2 = eahelp + 1; //fixed on the 65C02
+    else
+        eahelp2 = (eahelp & 0xFF00) | ((eahelp + 1) & 0x00FF); //replicate 6502 page-boundary wraparound bug
+    c->ea = (uint16_t)read6502(c, eahelp) | ((uint16_t)read6502(c, eahelp2) << 8);
+    c->pc += 2;
 }
 
-static void inzp() { //indirectZP
+static void inzp(struct cpu6502 *c) { //indirectZP
     uint16_t eahelp;
-    eahelp = (uint16_t)(((uint16_t)read6502(pc++)) & 0xFF); //zero-page wraparound for table pointer
-    ea = (uint16_t)read6502(eahelp & 0x00FF) | ((uint16_t)read6502((eahelp+1) & 0x00FF) << 8);
+    eahelp = (uint16_t)(((uint16_t)read6502(c, c->pc++)) & 0xFF); //zero-page wraparound for table pointer
+    c->ea = (uint16_t)read6502(c, eahelp & 0x00FF) | ((uint16_t)read6502(c, (eahelp+1) & 0x00FF) << 8);
 }
 
-static void indx() { // (indirect,X)
+static void indx(struct cpu6502 *c) { // (indirect,X)
     uint16_t eahelp;
-    eahelp = (uint16_t)(((uint16_t)read6502(pc++) + (uint16_t)x) & 0xFF); //zero-page wraparound for table pointer
-    ea = (uint16_t)read6502(eahelp & 0x00FF) | ((uint16_t)read6502((eahelp+1) & 0x00FF) << 8);
+    eahelp = (uint16_t)(((uint16_t)read6502(c, c->pc++) + (uint16_t)c->x) & 0xFF); //zero-page wraparound for table pointer
+    c->ea = (uint16_t)read6502(c, eahelp & 0x00FF) | ((uint16_t)read6502(c, (eahelp+1) & 0x00FF) << 8);
 }
 
-static void inax() { // (indirectABS,X)
+static void inax(struct cpu6502 *c) { // (indirectABS,X)
     uint16_t eahelp, eahelp2;
-    eahelp = ((uint16_t)read6502(pc) | (uint16_t)((uint16_t)read6502(pc+1) << 8)) + (uint16_t)x;
-    eahelp2 = (eahelp & 0xFF00) | ((eahelp + 1) & 0x00FF); //replicate 6502 page-boundary wraparound bug
-    ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
-    pc += 2;
+    eahelp = ((uint16_t)read6502(c, c->pc) | (uint16_t)((uint16_t)read6502(c, c->pc+1) << 8)) + (uint16_t)c->x;
+    eahelp2 = eahelp + 1; //65C02 only, so no page-boundary wraparound bug
+    c->ea = (uint16_t)read6502(c, eahelp) | ((uint16_t)read6502(c, eahelp2) << 8);
+    c->pc += 2;
 }
 
-static void indy() { // (indirect),Y
+static void indy(struct cpu6502 *c) { // (indirect),Y
     uint16_t eahelp, eahelp2, startpage;
-    eahelp = (uint16_t)read6502(pc++);
+    eahelp = (uint16_t)read6502(c, c->pc++);
     eahelp2 = (eahelp & 0xFF00) | ((eahelp + 1) & 0x00FF); //zero-page wraparound
-    ea = (uint16_t)read6502(eahelp) | ((uint16_t)read6502(eahelp2) << 8);
-    startpage = ea & 0xFF00;
-    ea += (uint16_t)y;
+    c->ea = (uint16_t)read6502(c, eahelp) | ((uint16_t)read6502(c, eahelp2) << 8);
+    startpage = c->ea & 0xFF00;
+    c->ea += (uint16_t)c->y;
 
-    if (startpage != (ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
-        penaltyaddr = 1;
+    if (startpage != (c->ea & 0xFF00)) { //one cycle penlty for page-crossing on some opcodes
+        c->penaltyaddr = 1;
     }
 }
 
-static uint16_t getvalue() {
-    if (addrtable[opcode] == acc) return((uint16_t)a);
-        else return((uint16_t)read6502(ea));
+static uint16_t getvalue(struct cpu6502 *c) {
+    if (c->addrtable[c->opcode] == acc) return((uint16_t)c->a);
+        else return((uint16_t)read6502(c, c->ea));
 }
 
-static void putvalue(uint16_t saveval) {
-    if (addrtable[opcode] == acc) a = (uint8_t)(saveval & 0x00FF);
-        else write6502(ea, (saveval & 0x00FF));
+static void putvalue(struct cpu6502 *c, uint16_t saveval) {
+    if (c->addrtable[c->opcode] == acc) c->a = (uint8_t)(saveval & 0x00FF);
+        else write6502(c, c->ea, (saveval & 0x00FF));
 }
 
 
+/* The 65C02 takes an extra cycle for decimal ADC and SBC, and sets N and Z
+   from the decimal result. */
+static void decimalfixup(struct cpu6502 *c) {
+    if (c->cmos) {
+        zerocalc(c->result);
+        signcalc(c->result);
+        c->clockticks6502++;
+    }
+}
+
 //instruction handler functions
-static void adc() {
-    penaltyop = 1;
-    value = getvalue();
-    result = (uint16_t)a + value + (uint16_t)(status & FLAG_CARRY);
+static void adc(struct cpu6502 *c) {
+    c->penaltyop = 1;
+    c->value = getvalue(c);
+    c->result = (uint16_t)c->a + c->value + (uint16_t)(c->status & FLAG_CARRY);
 
-    zerocalc(result);
-    overflowcalc(result, a, value);
-    signcalc(result);
+    zerocalc(c->result);
+    overflowcalc(c->result, c->a, c->value);
+    signcalc(c->result);
 
     #ifndef NES_CPU
-    if (status & FLAG_DECIMAL)       /* detect and apply BCD nybble carries */
-        result += ((((result + 0x66) ^ (uint16_t)a ^ value) >> 3) & 0x22) * 3;
+    if (c->status & FLAG_DECIMAL) {     /* detect and apply BCD nybble carries */
+        c->result += ((((c->result + 0x66) ^ (uint16_t)c->a ^ c->value) >> 3) & 0x22) * 3;
+        decimalfixup(c);
+    }
     #endif
 
-    carrycalc(result);
-    saveaccum(result);
+    carrycalc(c->result);
+    saveaccum(c->result);
 }
 
-static void and() {
-    penaltyop = 1;
-    value = getvalue();
-    result = (uint16_t)a & value;
+static void and(struct cpu6502 *c) {
+    c->penaltyop = 1;
+    c->value = getvalue(c);
+    c->result = (uint16_t)c->a & c->value;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(c->result);
+    signcalc(c->result);
 
-    saveaccum(result);
+    saveaccum(c->result);
 }
 
-static void asl() {
-    value = getvalue();
-    result = value << 1;
+static void asl(struct cpu6502 *c) {
+    c->penaltyop = c->cmos; /* 65C02 absolute,X takes the page crossing penalty */
+    c->value = getvalue(c);
+    c->result = c->value << 1;
 
-    carrycalc(result);
-    zerocalc(result);
-    signcalc(result);
+    carrycalc(c->result);
+    zerocalc(c->result);
+    signcalc(c->result);
 
-    putvalue(result);
+    putvalue(c, c->result);
 }
 
-static void bcc() {
-    if ((status & FLAG_CARRY) == 0) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bcc(struct cpu6502 *c) {
+    if ((c->status & FLAG_CARRY) == 0) {
+        c->oldpc = c->pc;
+        c->pc += c->reladdr;
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2; //check if jump crossed a page boundary
+            else c->clockticks6502++;
     }
 }
 
-static void bcs() {
-    if ((status & FLAG_CARRY) == FLAG_CARRY) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bcs(struct cpu6502 *c) {
+    if ((c->status & FLAG_CARRY) == FLAG_CARRY) {
+        c->oldpc = c->pc;
+        c->pc += c->reladdr;
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2; //check if jump crossed a page boundary
+            else c->clockticks6502++;
     }
 }
 
-static void beq() {
-    if ((status & FLAG_ZERO) == FLAG_ZERO) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void beq(struct cpu6502 *c) {
+    if ((c->status & FLAG_ZERO) == FLAG_ZERO) {
+        c->oldpc = c->pc;
+        c->pc += c->reladdr;
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2; //check if jump crossed a page boundary
+            else c->clockticks6502++;
     }
 }
 
-static void bra() {
-    oldpc = pc;
-    pc += reladdr;
-    if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 1; //check if jump crossed a page boundary
+static void bra(struct cpu6502 *c) {
+    c->oldpc = c->pc;
+    c->pc += c->reladdr;
+    if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 1; //check if jump crossed a page boundary
 }
 
-static void bit() {
-    value = getvalue();
-    result = (uint16_t)a & value;
+static void bit(struct cpu6502 *c) {
+    c->penaltyop = 1;
+    c->value = getvalue(c);
+    c->result = (uint16_t)c->a & c->value;
 
-    zerocalc(result);
-    status = (status & 0x3F) | (uint8_t)(value & 0xC0);
+    zerocalc(c->result);
+    c->status = (c->status & 0x3F) | (uint8_t)(c->value & 0xC0);
 }
 
-static void bmi() {
-    if ((status & FLAG_SIGN) == FLAG_SIGN) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bmi(struct cpu6502 *c) {
+    if ((c->status & FLAG_SIGN) == FLAG_SIGN) {
+        c->oldpc = c->pc;
+        c->pc += c->reladdr;
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2; //check if jump crossed a page boundary
+            else c->clockticks6502++;
     }
 }
 
-static void bne() {
-    if ((status & FLAG_ZERO) == 0) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bne(struct cpu6502 *c) {
+    if ((c->status & FLAG_ZERO) == 0) {
+        c->oldpc = c->pc;
+        c->pc += c->reladdr;
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2; //check if jump crossed a page boundary
+            else c->clockticks6502++;
     }
 }
 
-static void bpl() {
-    if ((status & FLAG_SIGN) == 0) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bpl(struct cpu6502 *c) {
+    if ((c->status & FLAG_SIGN) == 0) {
+        c->oldpc = c->pc;
+        c->pc += c->reladdr;
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2; //check if jump crossed a page boundary
+            else c->clockticks6502++;
     }
 }
 
-static void brk() {
-    pc++;
-    push16(pc); //push next instruction address onto stack
-    push8(status | FLAG_BREAK); //push CPU status to stack
+static void brk(struct cpu6502 *c) {
+    c->pc++;
+    push16(c, c->pc); //push next instruction address onto stack
+    push8(c, c->status | FLAG_BREAK); //push CPU status to stack
     setinterrupt(); //set interrupt flag
-    pc = (uint16_t)read6502(0xFFFE) | ((uint16_t)read6502(0xFFFF) << 8);
+    if (c->cmos)
+        cleardecimal();
+    c->pc = (uint16_t)read6502(c, 0xFFFE) | ((uint16_t)read6502(c, 0xFFFF) << 8);
 }
 
-static void bvc() {
-    if ((status & FLAG_OVERFLOW) == 0) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bvc(struct cpu6502 *c) {
+    if ((c->status & FLAG_OVERFLOW) == 0) {
+        c->oldpc = c->pc;
+        c->pc += c->reladdr;
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2; //check if jump crossed a page boundary
+            else c->clockticks6502++;
     }
 }
 
-static void bvs() {
-    if ((status & FLAG_OVERFLOW) == FLAG_OVERFLOW) {
-        oldpc = pc;
-        pc += reladdr;
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2; //check if jump crossed a page boundary
-            else clockticks6502++;
+static void bvs(struct cpu6502 *c) {
+    if ((c->status & FLAG_OVERFLOW) == FLAG_OVERFLOW) {
+        c->oldpc = c->pc;
+        c->pc += c->reladdr;
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2; //check if jump crossed a page boundary
+            else c->clockticks6502++;
     }
 }
 
-static void clc() {
+static void clc(struct cpu6502 *c) {
     clearcarry();
 }
 
-static void cld() {
+static void cld(struct cpu6502 *c) {
     cleardecimal();
 }
 
-static void cli() {
+static void cli(struct cpu6502 *c) {
     clearinterrupt();
 }
 
-static void clv() {
+static void clv(struct cpu6502 *c) {
     clearoverflow();
 }
 
-static void cmp() {
-    penaltyop = 1;
-    value = getvalue();
-    result = (uint16_t)a - value;
+static void cmp(struct cpu6502 *c) {
+    c->penaltyop = 1;
+    c->value = getvalue(c);
+    c->result = (uint16_t)c->a - c->value;
 
-    if (a >= (uint8_t)(value & 0x00FF)) setcarry();
+    if (c->a >= (uint8_t)(c->value & 0x00FF)) setcarry();
         else clearcarry();
-    if (a == (uint8_t)(value & 0x00FF)) setzero();
+    if (c->a == (uint8_t)(c->value & 0x00FF)) setzero();
         else clearzero();
-    signcalc(result);
+    signcalc(c->result);
 }
 
-static void cpx() {
-    value = getvalue();
-    result = (uint16_t)x - value;
+static void cpx(struct cpu6502 *c) {
+    c->value = getvalue(c);
+    c->result = (uint16_t)c->x - c->value;
 
-    if (x >= (uint8_t)(value & 0x00FF)) setcarry();
+    if (c->x >= (uint8_t)(c->value & 0x00FF)) setcarry();
         else clearcarry();
-    if (x == (uint8_t)(value & 0x00FF)) setzero();
+    if (c->x == (uint8_t)(c->value & 0x00FF)) setzero();
         else clearzero();
-    signcalc(result);
+    signcalc(c->result);
 }
 
-static void cpy() {
-    value = getvalue();
-    result = (uint16_t)y - value;
+static void cpy(struct cpu6502 *c) {
+    c->value = getvalue(c);
+    c->result = (uint16_t)c->y - c->value;
 
-    if (y >= (uint8_t)(value & 0x00FF)) setcarry();
+    if (c->y >= (uint8_t)(c->value & 0x00FF)) setcarry();
         else clearcarry();
-    if (y == (uint8_t)(value & 0x00FF)) setzero();
+    if (c->y == (uint8_t)(c->value & 0x00FF)) setzero();
         else clearzero();
-    signcalc(result);
+    signcalc(c->result);
 }
 
-static void dec() {
-    value = getvalue();
-    result = value - 1;
+static void dec(struct cpu6502 *c) {
+    c->value = getvalue(c);
+    c->result = c->value - 1;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(c->result);
+    signcalc(c->result);
 
-    putvalue(result);
+    putvalue(c, c->result);
 }
 
-static void dex() {
-    x--;
+static void dex(struct cpu6502 *c) {
+    c->x--;
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(c->x);
+    signcalc(c->x);
 }
 
-static void dey() {
-    y--;
+static void dey(struct cpu6502 *c) {
+    c->y--;
 
-    zerocalc(y);
-    signcalc(y);
+    zerocalc(c->y);
+    signcalc(c->y);
 }
 
-static void eor() {
-    penaltyop = 1;
-    value = getvalue();
-    result = (uint16_t)a ^ value;
+static void eor(struct cpu6502 *c) {
+    c->penaltyop = 1;
+    c->value = getvalue(c);
+    c->result = (uint16_t)c->a ^ c->value;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(c->result);
+    signcalc(c->result);
 
-    saveaccum(result);
+    saveaccum(c->result);
 }
 
-static void inc() {
-    value = getvalue();
-    result = value + 1;
+static void inc(struct cpu6502 *c) {
+    c->value = getvalue(c);
+    c->result = c->value + 1;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(c->result);
+    signcalc(c->result);
 
-    putvalue(result);
+    putvalue(c, c->result);
 }
 
-static void inx() {
-    x++;
+static void inx(struct cpu6502 *c) {
+    c->x++;
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(c->x);
+    signcalc(c->x);
 }
 
-static void iny() {
-    y++;
+static void iny(struct cpu6502 *c) {
+    c->y++;
 
-    zerocalc(y);
-    signcalc(y);
+    zerocalc(c->y);
+    signcalc(c->y);
 }
 
-static void jmp() {
-    pc = ea;
+static void jmp(struct cpu6502 *c) {
+    c->pc = c->ea;
 }
 
-static void jsr() {
-    push16(pc - 1);
-    pc = ea;
+static void jsr(struct cpu6502 *c) {
+    push16(c, c->pc - 1);
+    c->pc = c->ea;
 }
 
-static void lda() {
-    penaltyop = 1;
-    value = getvalue();
-    a = (uint8_t)(value & 0x00FF);
+static void lda(struct cpu6502 *c) {
+    c->penaltyop = 1;
+    c->value = getvalue(c);
+    c->a = (uint8_t)(c->value & 0x00FF);
 
-    zerocalc(a);
-    signcalc(a);
+    zerocalc(c->a);
+    signcalc(c->a);
 }
 
-static void ldx() {
-    penaltyop = 1;
-    value = getvalue();
-    x = (uint8_t)(value & 0x00FF);
+static void ldx(struct cpu6502 *c) {
+    c->penaltyop = 1;
+    c->value = getvalue(c);
+    c->x = (uint8_t)(c->value & 0x00FF);
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(c->x);
+    signcalc(c->x);
 }
 
-static void ldy() {
-    penaltyop = 1;
-    value = getvalue();
-    y = (uint8_t)(value & 0x00FF);
+static void ldy(struct cpu6502 *c) {
+    c->penaltyop = 1;
+    c->value = getvalue(c);
+    c->y = (uint8_t)(c->value & 0x00FF);
 
-    zerocalc(y);
-    signcalc(y);
+    zerocalc(c->y);
+    signcalc(c->y);
 }
 
-static void lsr() {
-    value = getvalue();
-    result = value >> 1;
+static void lsr(struct cpu6502 *c) {
+    c->penaltyop = c->cmos; /* 65C02 absolute,X takes the page crossing penalty */
+    c->value = getvalue(c);
+    c->result = c->value >> 1;
 
-    if (value & 1) setcarry();
+    if (c->value & 1) setcarry();
         else clearcarry();
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(c->result);
+    signcalc(c->result);
 
-    putvalue(result);
+    putvalue(c, c->result);
 }
 
-static void nop() {
-    switch (opcode) {
+static void nop(struct cpu6502 *c) {
+    switch (c->opcode) {
         case 0x1C:
         case 0x3C:
         case 0x5C:
         case 0x7C:
         case 0xDC:
         case 0xFC:
-            penaltyop = 1;
+            c->penaltyop = 1;
             break;
     }
 }
 
-static void ora() {
-    penaltyop = 1;
-    value = getvalue();
-    result = (uint16_t)a | value;
+static void ora(struct cpu6502 *c) {
+    c->penaltyop = 1;
+    c->value = getvalue(c);
+    c->result = (uint16_t)c->a | c->value;
 
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(c->result);
+    signcalc(c->result);
 
-    saveaccum(result);
+    saveaccum(c->result);
 }
 
-static void pha() {
-    push8(a);
+static void pha(struct cpu6502 *c) {
+    push8(c, c->a);
 }
 
-static void php() {
-    push8(status | FLAG_BREAK);
+static void php(struct cpu6502 *c) {
+    push8(c, c->status | FLAG_BREAK);
 }
 
-static void phx() {
-    push8(x);
+static void phx(struct cpu6502 *c) {
+    push8(c, c->x);
 }
 
-static void phy() {
-    push8(y);
+static void phy(struct cpu6502 *c) {
+    push8(c, c->y);
 }
 
-static void pla() {
-    a = pull8();
+static void pla(struct cpu6502 *c) {
+    c->a = pull8(c);
 
-    zerocalc(a);
-    signcalc(a);
+    zerocalc(c->a);
+    signcalc(c->a);
 }
 
-static void plp() {
-    status = pull8() | FLAG_CONSTANT;
+static void plp(struct cpu6502 *c) {
+    c->status = pull8(c) | FLAG_CONSTANT;
 }
 
-static void plx() {
-    x = pull8();
+static void plx(struct cpu6502 *c) {
+    c->x = pull8(c);
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(c->x);
+    signcalc(c->x);
 }
 
-static void ply() {
-    y = pull8();
+static void ply(struct cpu6502 *c) {
+    c->y = pull8(c);
 
-    zerocalc(y);
-    signcalc(y);
+    zerocalc(c->y);
+    signcalc(c->y);
 }
 
-static void rol() {
-    value = getvalue();
-    result = (value << 1) | (status & FLAG_CARRY);
+static void rol(struct cpu6502 *c) {
+    c->penaltyop = c->cmos; /* 65C02 absolute,X takes the page crossing penalty */
+    c->value = getvalue(c);
+    c->result = (c->value << 1) | (c->status & FLAG_CARRY);
 
-    carrycalc(result);
-    zerocalc(result);
-    signcalc(result);
+    carrycalc(c->result);
+    zerocalc(c->result);
+    signcalc(c->result);
 
-    putvalue(result);
+    putvalue(c, c->result);
 }
 
-static void ror() {
-    value = getvalue();
-    result = (value >> 1) | ((status & FLAG_CARRY) << 7);
+static void ror(struct cpu6502 *c) {
+    c->penaltyop = c->cmos; /* 65C02 absolute,X takes the page crossing penalty */
+    c->value = getvalue(c);
+    c->result = (c->value >> 1) | ((c->status & FLAG_CARRY) << 7);
 
-    if (value & 1) setcarry();
+    if (c->value & 1) setcarry();
         else clearcarry();
-    zerocalc(result);
-    signcalc(result);
+    zerocalc(c->result);
+    signcalc(c->result);
 
-    putvalue(result);
+    putvalue(c, c->result);
 }
 
-static void rti() {
-    status = pull8();
-    value = pull16();
-    pc = value;
+static void rti(struct cpu6502 *c) {
+    c->status = pull8(c);
+    c->value = pull16(c);
+    c->pc = c->value;
 }
 
-static void rts() {
-    value = pull16();
-    pc = value + 1;
+static void rts(struct cpu6502 *c) {
+    c->value = pull16(c);
+    c->pc = c->value + 1;
 }
 
-static void sbc() {
-  penaltyop = 1;
-  value = getvalue() ^ 0x00FF; /* ones complement */
+static void sbc(struct cpu6502 *c) {
+  c->penaltyop = 1;
+  c->value = getvalue(c) ^ 0x00FF; /* ones complement */
 
 #ifndef NES_CPU
-  if (status & FLAG_DECIMAL) /* use nines complement for BCD */
-    value -= 0x0066;
+  if (c->status & FLAG_DECIMAL) /* use nines complement for BCD */
+    c->value -= 0x0066;
 #endif
 
-  result = (uint16_t)a + value + (uint16_t)(status & FLAG_CARRY);
+  c->result = (uint16_t)c->a + c->value + (uint16_t)(c->status & FLAG_CARRY);
 
-  zerocalc(result);
-  overflowcalc(result, a, value);
-  signcalc(result);
+  zerocalc(c->result);
+  overflowcalc(c->result, c->a, c->value);
+  signcalc(c->result);
 
 #ifndef NES_CPU
-  if (status & FLAG_DECIMAL) /* detect and apply BCD nybble carries */
-    result += ((((result + 0x66) ^ (uint16_t)a ^ value) >> 3) & 0x22) * 3;
+  if (c->status & FLAG_DECIMAL) { /* detect and apply BCD nybble carries */
+    c->result += ((((c->result + 0x66) ^ (uint16_t)c->a ^ c->value) >> 3) & 0x22) * 3;
+    decimalfixup(c);
+  }
 #endif
 
-  carrycalc(result);
-  saveaccum(result);
+  carrycalc(c->result);
+  saveaccum(c->result);
 }
 
-static void sec() {
+static void sec(struct cpu6502 *c) {
     setcarry();
 }
 
-static void sed() {
+static void sed(struct cpu6502 *c) {
     setdecimal();
 }
 
-static void sei() {
+static void sei(struct cpu6502 *c) {
     setinterrupt();
 }
 
-static void sta() {
-    putvalue(a);
+static void sta(struct cpu6502 *c) {
+    putvalue(c, c->a);
 }
 
-static void stx() {
-    putvalue(x);
+static void stx(struct cpu6502 *c) {
+    putvalue(c, c->x);
 }
 
-static void sty() {
-    putvalue(y);
+static void sty(struct cpu6502 *c) {
+    putvalue(c, c->y);
 }
 
-static void stz() {
-    putvalue(0);
+static void stz(struct cpu6502 *c) {
+    putvalue(c, 0);
 }
 
-static void tax() {
-    x = a;
+static void tax(struct cpu6502 *c) {
+    c->x = c->a;
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(c->x);
+    signcalc(c->x);
 }
 
-static void tay() {
-    y = a;
+static void tay(struct cpu6502 *c) {
+    c->y = c->a;
 
-    zerocalc(y);
-    signcalc(y);
+    zerocalc(c->y);
+    signcalc(c->y);
 }
 
-static void tsx() {
-    x = sp;
+static void tsx(struct cpu6502 *c) {
+    c->x = c->sp;
 
-    zerocalc(x);
-    signcalc(x);
+    zerocalc(c->x);
+    signcalc(c->x);
 }
 
-static void txa() {
-    a = x;
+static void txa(struct cpu6502 *c) {
+    c->a = c->x;
 
-    zerocalc(a);
-    signcalc(a);
+    zerocalc(c->a);
+    signcalc(c->a);
 }
 
-static void txs() {
-    sp = x;
+static void txs(struct cpu6502 *c) {
+    c->sp = c->x;
 }
 
-static void tya() {
-    a = y;
+static void tya(struct cpu6502 *c) {
+    c->a = c->y;
 
-    zerocalc(a);
-    signcalc(a);
+    zerocalc(c->a);
+    signcalc(c->a);
 }
 
-static void tsb() {
-    value = getvalue();
-    zerocalc(value & a);
-    putvalue(value | a);
+static void tsb(struct cpu6502 *c) {
+    c->value = getvalue(c);
+    zerocalc(c->value & c->a);
+    putvalue(c, c->value | c->a);
 }
 
-static void trb() {
-    value = getvalue();
-    zerocalc(value & a);
-    putvalue(value & ~a);
+static void trb(struct cpu6502 *c) {
+    c->value = getvalue(c);
+    zerocalc(c->value & c->a);
+    putvalue(c, c->value & ~c->a);
 }
 
 #define DEF_BBR(idx)                                                           \
-static void bbr##idx() {                                                       \
-    value = getvalue();                                                        \
-    if ((value & (1 << (idx))) == 0) {                                         \
-        oldpc = pc;                                                            \
-        pc += reladdr;                                                         \
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2;            \
-            else clockticks6502++;                                             \
+static void bbr##idx(struct cpu6502 *c) {                                      \
+    c->value = getvalue(c);                                                    \
+    if ((c->value & (1 << (idx))) == 0) {                                      \
+        c->oldpc = c->pc;                                                      \
+        c->pc += c->reladdr;                                                   \
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2;   \
+            else c->clockticks6502++;                                          \
     }                                                                          \
 }
 DEF_BBR(0)
@@ -853,13 +869,13 @@ DEF_BBR(6)
 DEF_BBR(7)
 
 #define DEF_BBS(idx)                                                           \
-static void bbs##idx() {                                                       \
-    value = getvalue();                                                        \
-    if ((value & (1 << (idx))) != 0) {                                         \
-        oldpc = pc;                                                            \
-        pc += reladdr;                                                         \
-        if ((oldpc & 0xFF00) != (pc & 0xFF00)) clockticks6502 += 2;            \
-            else clockticks6502++;                                             \
+static void bbs##idx(struct cpu6502 *c) {                                      \
+    c->value = getvalue(c);                                                    \
+    if ((c->value & (1 << (idx))) != 0) {                                      \
+        c->oldpc = c->pc;                                                      \
+        c->pc += c->reladdr;                                                   \
+        if ((c->oldpc & 0xFF00) != (c->pc & 0xFF00)) c->clockticks6502 += 2;   \
+            else c->clockticks6502++;                                          \
     }                                                                          \
 }
 DEF_BBS(0)
@@ -872,10 +888,10 @@ DEF_BBS(6)
 DEF_BBS(7)
 
 #define DEF_RMB(idx)                                                           \
-static void rmb##idx() {                                                       \
-    value = getvalue();                                                        \
-    value &= ~(1 << (idx));                                                    \
-    putvalue(value);                                                           \
+static void rmb##idx(struct cpu6502 *c) {                                      \
+    c->value = getvalue(c);                                                    \
+    c->value &= ~(1 << (idx));                                                 \
+    putvalue(c, c->value);                                                     \
 }
 DEF_RMB(0)
 DEF_RMB(1)
@@ -887,10 +903,10 @@ DEF_RMB(6)
 DEF_RMB(7)
 
 #define DEF_SMB(idx)                                                           \
-static void smb##idx() {                                                       \
-    value = getvalue();                                                        \
-    value |= 1 << (idx);                                                       \
-    putvalue(value);                                                           \
+static void smb##idx(struct cpu6502 *c) {                                      \
+    c->value = getvalue(c);                                                    \
+    c->value |= 1 << (idx);                                                    \
+    putvalue(c, c->value);                                                     \
 }
 DEF_SMB(0)
 DEF_SMB(1)
@@ -902,57 +918,57 @@ DEF_SMB(6)
 DEF_SMB(7)
 
 // TODO: Implement these by adding emulation wait and stop states.
-static void wai() {}
-static void stp() {}
+static void wai(struct cpu6502 *c) {}
+static void stp(struct cpu6502 *c) {}
 
 //undocumented instructions
 #ifdef UNDOCUMENTED
-    static void lax() {
-        lda();
-        ldx();
+    static void lax(struct cpu6502 *c) {
+        lda(c);
+        ldx(c);
     }
 
-    static void sax() {
-        sta();
-        stx();
-        putvalue(a & x);
-        if (penaltyop && penaltyaddr) clockticks6502--;
+    static void sax(struct cpu6502 *c) {
+        sta(c);
+        stx(c);
+        putvalue(c, c->a & c->x);
+        if (c->penaltyop && c->penaltyaddr) c->clockticks6502--;
     }
 
-    static void dcp() {
-        dec();
-        cmp();
-        if (penaltyop && penaltyaddr) clockticks6502--;
+    static void dcp(struct cpu6502 *c) {
+        dec(c);
+        cmp(c);
+        if (c->penaltyop && c->penaltyaddr) c->clockticks6502--;
     }
 
-    static void isb() {
-        inc();
-        sbc();
-        if (penaltyop && penaltyaddr) clockticks6502--;
+    static void isb(struct cpu6502 *c) {
+        inc(c);
+        sbc(c);
+        if (c->penaltyop && c->penaltyaddr) c->clockticks6502--;
     }
 
-    static void slo() {
-        asl();
-        ora();
-        if (penaltyop && penaltyaddr) clockticks6502--;
+    static void slo(struct cpu6502 *c) {
+        asl(c);
+        ora(c);
+        if (c->penaltyop && c->penaltyaddr) c->clockticks6502--;
     }
 
-    static void rla() {
-        rol();
-        and();
-        if (penaltyop && penaltyaddr) clockticks6502--;
+    static void rla(struct cpu6502 *c) {
+        rol(c);
+        and(c);
+        if (c->penaltyop && c->penaltyaddr) c->clockticks6502--;
     }
 
-    static void sre() {
-        lsr();
-        eor();
-        if (penaltyop && penaltyaddr) clockticks6502--;
+    static void sre(struct cpu6502 *c) {
+        lsr(c);
+        eor(c);
+        if (c->penaltyop && c->penaltyaddr) c->clockticks6502--;
     }
 
-    static void rra() {
-        ror();
-        adc();
-        if (penaltyop && penaltyaddr) clockticks6502--;
+    static void rra(struct cpu6502 *c) {
+        ror(c);
+        adc(c);
+        if (c->penaltyop && c->penaltyaddr) c->clockticks6502--;
     }
 #else
     #define lax nop
@@ -966,7 +982,7 @@ static void stp() {}
 #endif
 
 
-static void (*addrtable_nmos[256])() = {
+static void (*addrtable_nmos[256])(struct cpu6502 *) = {
 /*        |  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F  |     */
 /* 0 */     imp, indx,  imp, indx,   zp,   zp,   zp,   zp,  imp,  imm,  acc,  imm, abso, abso, abso, abso, /* 0 */
 /* 1 */     rel, indy,  imp, indy,  zpx,  zpx,  zpx,  zpx,  imp, absy,  imp, absy, absx, absx, absx, absx, /* 1 */
@@ -986,7 +1002,7 @@ static void (*addrtable_nmos[256])() = {
 /* F */     rel, indy,  imp, indy,  zpx,  zpx,  zpx,  zpx,  imp, absy,  imp, absy, absx, absx, absx, absx  /* F */
 };
 
-static void (*optable_nmos[256])() = {
+static void (*optable_nmos[256])(struct cpu6502 *) = {
 /*        |  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F  |     */
 /* 0 */     brk,  ora,  nop,  slo,  nop,  ora,  asl,  slo,  php,  ora,  asl,  nop,  nop,  ora,  asl,  slo, /* 0 */
 /* 1 */     bpl,  ora,  nop,  slo,  nop,  ora,  asl,  slo,  clc,  ora,  nop,  slo,  nop,  ora,  asl,  slo, /* 1 */
@@ -1026,7 +1042,7 @@ static const uint32_t ticktable_nmos[256] = {
 /* F */      2,    5,    2,    8,    4,    4,    6,    6,    2,    4,    2,    7,    4,    4,    7,    7   /* F */
 };
 
-static void (*addrtable_cmos[256])() = {
+static void (*addrtable_cmos[256])(struct cpu6502 *) = {
 /*        |  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7  |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F  |     */
 /* 0 */     imp, indx,  imm,  imp,   zp,   zp,   zp,   zp,  imp,  imm,  acc,  imp, abso, abso, abso,  zpr, /* 0 */
 /* 1 */     rel, indy, inzp,  imp,   zp,  zpx,  zpx,   zp,  imp, absy,  imp,  imp, abso, absx, absx,  zpr, /* 1 */
@@ -1046,7 +1062,7 @@ static void (*addrtable_cmos[256])() = {
 /* F */     rel, indy, inzp,  imp,  zpx,  zpx,  zpx,   zp,  imp, absy,  imp,  imp, abso, absx, absx,  zpr  /* F */
 };
 
-static void (*optable_cmos[256])() = {
+static void (*optable_cmos[256])(struct cpu6502 *) = {
 /*        |  0  |  1  |  2  |  3  |  4  |  5  |  6  |  7   |  8  |  9  |  A  |  B  |  C  |  D  |  E  |  F   |     */
 /* 0 */     brk,  ora,  nop,  nop,  tsb,  ora,  asl,  rmb0,  php,  ora,  asl,  nop,  tsb,  ora,  asl,  bbr0, /* 0 */
 /* 1 */     bpl,  ora,  ora,  nop,  trb,  ora,  asl,  rmb1,  clc,  ora,  inc,  nop,  trb,  ora,  asl,  bbr1, /* 1 */
@@ -1086,85 +1102,97 @@ static const uint32_t ticktable_cmos[256] = {
 /* F */      2,    5,    5,    1,    4,    4,    6,    5,    2,    4,    4,    1,    4,    4,    7,    5   /* F */
 };
 
-void nmi6502() {
-    push16(pc);
-    push8(status);
-    status |= FLAG_INTERRUPT;
-    pc = (uint16_t)read6502(0xFFFA) | ((uint16_t)read6502(0xFFFB) << 8);
+/* Hardware interrupts push the status with B clear and take 7 cycles, like
+   BRK. The 65C02 also clears the decimal flag. */
+static void interrupt6502(struct cpu6502 *c, uint16_t vector) {
+    push16(c, c->pc);
+    push8(c, c->status & ~FLAG_BREAK);
+    setinterrupt();
+    if (c->cmos)
+        cleardecimal();
+    c->pc = (uint16_t)read6502(c, vector) | ((uint16_t)read6502(c, vector + 1) << 8);
+    c->clockticks6502 += 7;
 }
 
-void irq6502() {
-    push16(pc);
-    push8(status);
-    status |= FLAG_INTERRUPT;
-    pc = (uint16_t)read6502(0xFFFE) | ((uint16_t)read6502(0xFFFF) << 8);
+void nmi6502(struct cpu6502 *c) {
+    interrupt6502(c, 0xFFFA);
 }
 
-uint8_t callexternal = 0;
-void (*loopexternal)();
+void irq6502(struct cpu6502 *c) {
+    interrupt6502(c, 0xFFFE);
+}
 
-void exec6502(uint32_t tickcount) {
-    clockgoal6502 += tickcount;
+void exec6502(struct cpu6502 *c, uint32_t tickcount) {
+    c->clockgoal6502 += tickcount;
 
-    while (clockticks6502 < clockgoal6502) {
-        opcode = read6502(pc++);
-        status |= FLAG_CONSTANT;
+    while (c->clockticks6502 < c->clockgoal6502) {
+        c->opcode = read6502(c, c->pc++);
+        c->status |= FLAG_CONSTANT;
 
-        penaltyop = 0;
-        penaltyaddr = 0;
+        c->penaltyop = 0;
+        c->penaltyaddr = 0;
 
-        (*addrtable[opcode])();
-        (*optable[opcode])();
-        clockticks6502 += ticktable[opcode];
-        if (penaltyop && penaltyaddr) clockticks6502++;
+        (*c->addrtable[c->opcode])(c);
+        (*c->optable[c->opcode])(c);
+        c->clockticks6502 += c->ticktable[c->opcode];
+        if (c->penaltyop && c->penaltyaddr) c->clockticks6502++;
 
-        instructions++;
+        c->instructions++;
 
-        if (callexternal) (*loopexternal)();
+        if (c->callexternal) (*c->loopexternal)(c);
     }
 
 }
 
-void reset6502(uint8_t cmos) {
+void init6502(struct cpu6502 *c, uint8_t (*read)(struct cpu6502 *, uint16_t),
+              void (*write)(struct cpu6502 *, uint16_t, uint8_t), void *user) {
+    memset(c, 0, sizeof(*c));
+    c->read = read;
+    c->write = write;
+    c->user = user;
+}
+
+void reset6502(struct cpu6502 *c, uint8_t cmos) {
+    c->cmos = cmos != 0;
     if (cmos != 0) {
-        addrtable = addrtable_cmos;
-        optable = optable_cmos;
-        ticktable = ticktable_cmos;
+        c->addrtable = addrtable_cmos;
+        c->optable = optable_cmos;
+        c->ticktable = ticktable_cmos;
     } else {
-        addrtable = addrtable_nmos;
-        optable = optable_nmos;
-        ticktable = ticktable_nmos;
+        c->addrtable = addrtable_nmos;
+        c->optable = optable_nmos;
+        c->ticktable = ticktable_nmos;
     }
 
-    pc = (uint16_t)read6502(0xFFFC) | ((uint16_t)read6502(0xFFFD) << 8);
-    a = 0;
-    x = 0;
-    y = 0;
-    sp = 0xFD;
-    status |= FLAG_CONSTANT;
+    c->pc = (uint16_t)read6502(c, 0xFFFC) | ((uint16_t)read6502(c, 0xFFFD) << 8);
+    c->a = 0;
+    c->x = 0;
+    c->y = 0;
+    c->sp = 0xFD;
+    c->status |= FLAG_CONSTANT | FLAG_INTERRUPT;
 }
 
-void step6502() {
-    opcode = read6502(pc++);
-    status |= FLAG_CONSTANT;
+void step6502(struct cpu6502 *c) {
+    c->opcode = read6502(c, c->pc++);
+    c->status |= FLAG_CONSTANT;
 
-    penaltyop = 0;
-    penaltyaddr = 0;
+    c->penaltyop = 0;
+    c->penaltyaddr = 0;
 
-    (*addrtable[opcode])();
-    (*optable[opcode])();
-    clockticks6502 += ticktable[opcode];
-    if (penaltyop && penaltyaddr) clockticks6502++;
-    clockgoal6502 = clockticks6502;
+    (*c->addrtable[c->opcode])(c);
+    (*c->optable[c->opcode])(c);
+    c->clockticks6502 += c->ticktable[c->opcode];
+    if (c->penaltyop && c->penaltyaddr) c->clockticks6502++;
+    c->clockgoal6502 = c->clockticks6502;
 
-    instructions++;
+    c->instructions++;
 
-    if (callexternal) (*loopexternal)();
+    if (c->callexternal) (*c->loopexternal)(c);
 }
 
-void hookexternal(void *funcptr) {
-    if (funcptr != (void *)NULL) {
-        loopexternal = funcptr;
-        callexternal = 1;
-    } else callexternal = 0;
+void hookexternal(struct cpu6502 *c, void (*funcptr)(struct cpu6502 *)) {
+    if (funcptr != NULL) {
+        c->loopexternal = funcptr;
+        c->callexternal = 1;
+    } else c->callexternal = 0;
 }
@@ -0,0 +1,64 @@
+#ifndef _FAKE6502_H_
+#define _FAKE6502_H_
+
+#include <stdint.h>
+
+// Status register bits.
+#define FLAG_CARRY     0x01
+#define FLAG_ZERO      0x02
+#define FLAG_INTERRUPT 0x04
+#define FLAG_DECIMAL   0x08
+#define FLAG_BREAK     0x10
+#define FLAG_CONSTANT  0x20
+#define FLAG_OVERFLOW  0x40
+#define FLAG_SIGN      0x80
+
+// The complete state of one emulated CPU. Every entry point takes a pointer
+// to one of these, so any number of CPUs can run side by side in a process.
+struct cpu6502 {
+  // Registers
+  uint16_t pc;
+  uint8_t sp, a, x, y, status;
+
+  // Running totals of emulated cycles and instructions.
+  uint32_t clockticks6502, clockgoal6502;
+  uint32_t instructions;
+
+  // Memory map. Accesses to a 256-byte page with a non-NULL entry go
+  // directly to that host memory; all others go through the callbacks. Maps
+  // may be changed at any time between instructions.
+  const uint8_t *readmap[256];
+  uint8_t *writemap[256];
+  uint8_t (*read)(struct cpu6502 *c, uint16_t address);
+  void (*write)(struct cpu6502 *c, uint16_t address, uint8_t value);
+
+  // Owned by the embedder.
+  void *user;
+
+  // Decoder scratch state; only meaningful during an instruction.
+  uint16_t oldpc, ea, reladdr, value, result;
+  uint8_t opcode, oldstatus;
+  uint8_t penaltyop, penaltyaddr;
+
+  // Instruction set and tables selected by reset6502.
+  uint8_t cmos;
+  void (**addrtable)(struct cpu6502 *);
+  void (**optable)(struct cpu6502 *);
+  const uint32_t *ticktable;
+
+  uint8_t callexternal;
+  void (*loopexternal)(struct cpu6502 *);
+};
+
+// Clears the context and installs the memory callbacks; the maps start out
+// empty.
+void init6502(struct cpu6502 *c, uint8_t (*read)(struct cpu6502 *, uint16_t),
+              void (*write)(struct cpu6502 *, uint16_t, uint8_t), void *user);
+void reset6502(struct cpu6502 *c, uint8_t cmos);
+void step6502(struct cpu6502 *c);
+void exec6502(struct cpu6502 *c, uint32_t tickcount);
+void irq6502(struct cpu6502 *c);
+void nmi6502(struct cpu6502 *c);
+void hookexternal(struct cpu6502 *c, void (*funcptr)(struct cpu6502 *));
+
+#endif // _FAKE6502_H_
@@ -0,0 +1,493 @@
+// GDB remote serial protocol stub for mos-sim.
+//
+// Supports register and memory access, software breakpoints (Z0/Z1),
+// watchpoints (Z2-Z4), continue, single step and interrupting a running
+// program with Ctrl-C. The registers are, in order: a, x, y, s, p (8 bits
+// each) and pc (16 bits); the layout is also served as target.xml.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET socket_t;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int socket_t;
+#define INVALID_SOCKET (-1)
+#define closesocket close
+#endif
+
+#include "mos-sim.h"
+
+static const char targetXml[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
+    "<target version=\"1.0\">\n"
+    "  <feature name=\"org.llvm-mos.sim\">\n"
+    "    <reg name=\"a\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"x\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"y\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"s\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"p\" bitsize=\"8\" type=\"uint8\"/>\n"
+    "    <reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/>\n"
+    "  </feature>\n"
+    "</target>\n";
+
+static const char xferPrefix[] = "qXfer:features:read:target.xml:";
+
+#define NUM_REGS 6
+#define MAX_PACKET 4096
+// Instructions between checks for a Ctrl-C from the debugger.
+#define POLL_INTERVAL 0x10000
+
+#define SIGINT_ 2
+#define SIGTRAP_ 5
+#define SIGABRT_ 6
+
+struct gdbConnection {
+  socket_t fd;
+  uint8_t buf[MAX_PACKET];
+  size_t len, pos;
+};
+
+// Breakpoint flag per address; allocated when the first one is set.
+static uint8_t *breakpoints;
+static unsigned numBreakpoints;
+
+static int getByte(struct gdbConnection *g) {
+  if (g->pos == g->len) {
+    int n = recv(g->fd, (char *)g->buf, sizeof(g->buf), 0);
+    if (n <= 0)
+      return -1;
+    g->len = n;
+    g->pos = 0;
+  }
+  return g->buf[g->pos++];
+}
+
+// Returns whether a byte can be read without blocking.
+static bool inputPending(struct gdbConnection *g) {
+  if (g->pos < g->len)
+    return true;
+  fd_set fds;
+  FD_ZERO(&fds);
+  FD_SET(g->fd, &fds);
+  struct timeval timeout = {0, 0};
+  return select(g->fd + 1, &fds, NULL, NULL, &timeout) > 0;
+}
+
+static void sendAll(struct gdbConnection *g, const char *data, size_t len) {
+  while (len) {
+    int n = send(g->fd, data, len, 0);
+    if (n <= 0)
+      return;
+    data += n;
+    len -= n;
+  }
+}
+
+static void sendPacket(struct gdbConnection *g, const char *data) {
+  static char packet[2 * MAX_PACKET + 4];
+  size_t len = strlen(data);
+  uint8_t sum = 0;
+  for (size_t i = 0; i < len; ++i)
+    sum += (uint8_t)data[i];
+  snprintf(packet, sizeof(packet), "$%s#%02x", data, sum);
+  sendAll(g, packet, len + 4);
+}
+
+// Reads the next packet into out, acknowledging it. Returns false when the
+// connection closes.
+static bool receivePacket(struct gdbConnection *g, char *out) {
+  for (;;) {
+    int ch;
+    do {
+      ch = getByte(g);
+      if (ch < 0)
+        return false;
+    } while (ch != '$');
+
+    size_t len = 0;
+    uint8_t sum = 0;
+    while ((ch = getByte(g)) >= 0 && ch != '#') {
+      if (len < MAX_PACKET - 1)
+        out[len++] = ch;
+      sum += ch;
+    }
+    if (ch < 0)
+      return false;
+    char checksum[3] = {0};
+    for (int i = 0; i < 2; ++i) {
+      if ((ch = getByte(g)) < 0)
+        return false;
+      checksum[i] = ch;
+    }
+    out[len] = '\0';
+    if (strtoul(checksum, NULL, 16) == sum) {
+      sendAll(g, "+", 1);
+      return true;
+    }
+    sendAll(g, "-", 1);
+  }
+}
+
+static int hexDigit(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+static bool parseHexBytes(const char *hex, uint8_t *out, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    int hi = hexDigit(hex[2 * i]), lo = hexDigit(hex[2 * i + 1]);
+    if (hi < 0 || lo < 0)
+      return false;
+    out[i] = hi << 4 | lo;
+  }
+  return true;
+}
+
+static void readRegisters(const struct cpu6502 *c, uint8_t *regs) {
+  regs[0] = c->a;
+  regs[1] = c->x;
+  regs[2] = c->y;
+  regs[3] = c->sp;
+  regs[4] = c->status;
+  regs[5] = c->pc & 0xff;
+  regs[6] = c->pc >> 8;
+}
+
+static void writeRegisters(struct cpu6502 *c, const uint8_t *regs) {
+  c->a = regs[0];
+  c->x = regs[1];
+  c->y = regs[2];
+  c->sp = regs[3];
+  c->status = regs[4];
+  c->pc = regs[5] | regs[6] << 8;
+}
+
+// Byte offset and size of register n in the readRegisters layout.
+static bool registerSlot(unsigned long n, int *offset, int *size) {
+  if (n >= NUM_REGS)
+    return false;
+  *offset = n;
+  *size = n == NUM_REGS - 1 ? 2 : 1;
+  return true;
+}
+
+static void setBreakpoint(uint16_t address, bool set) {
+  if (!breakpoints) {
+    breakpoints = calloc(65536, 1);
+    if (!breakpoints) {
+      perror("calloc");
+      exit(1);
+    }
+  }
+  if (breakpoints[address] == set)
+    return;
+  breakpoints[address] = set;
+  numBreakpoints += set ? 1 : -1;
+}
+
+static void setWatchpoint(struct machine *m, uint16_t address, uint8_t kind,
+                          bool set) {
+  if (!m->watchpoints) {
+    m->watchpoints = calloc(65536, 1);
+    if (!m->watchpoints) {
+      perror("calloc");
+      exit(1);
+    }
+  }
+  uint8_t old = m->watchpoints[address];
+  uint8_t new = set ? old | kind : old & ~kind;
+  if (old == new)
+    return;
+  m->watchpoints[address] = new;
+  uint8_t page = address >> 8;
+  if ((old ^ new) & WATCH_READ)
+    m->readWatches[page] += new & WATCH_READ ? 1 : -1;
+  if ((old ^ new) & WATCH_WRITE)
+    m->writeWatches[page] += new & WATCH_WRITE ? 1 : -1;
+  mapPage(m, page);
+}
+
+// Resumes execution until a breakpoint, watchpoint, interrupt, or the end of
+// the program, then formats the stop reply.
+static void resume(struct gdbConnection *g, struct machine *m, bool singleStep,
+                   char *reply) {
+  struct cpu6502 *c = &m->cpu;
+  int signal = SIGTRAP_;
+  m->state = RUNNING;
+  for (uint32_t n = 1; m->state == RUNNING; ++n) {
+    stepMachine(m);
+    // Snapshots are not taken under the debugger.
+    if (m->state == SNAPSHOT_REQUESTED)
+      m->state = RUNNING;
+    if (singleStep)
+      break;
+    // Breakpoints stop before the instruction at their address executes.
+    if (numBreakpoints && breakpoints[c->pc])
+      break;
+    if (!(n % POLL_INTERVAL) && inputPending(g) && getByte(g) == 0x03) {
+      signal = SIGINT_;
+      break;
+    }
+  }
+
+  switch (m->state) {
+  case EXITED:
+    sprintf(reply, "W%02x", m->exitCode);
+    break;
+  case ABORTED:
+    sprintf(reply, "X%02x", SIGABRT_);
+    break;
+  case WATCHPOINT_HIT: {
+    uint8_t kinds = m->watchpoints[m->watchAddress];
+    const char *type = kinds == (WATCH_READ | WATCH_WRITE) ? "awatch"
+                       : m->watchKind == WATCH_READ        ? "rwatch"
+                                                           : "watch";
+    sprintf(reply, "T%02x%s:%04x;", SIGTRAP_, type, m->watchAddress);
+    break;
+  }
+  default:
+    sprintf(reply, "S%02x", signal);
+    break;
+  }
+}
+
+static bool acceptConnection(unsigned port, socket_t *fd) {
+#ifdef _WIN32
+  WSADATA wsa;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa)) {
+    fputs("Could not initialize Winsock.\n", stderr);
+    return false;
+  }
+#endif
+  socket_t listener = socket(AF_INET, SOCK_STREAM, 0);
+  if (listener == INVALID_SOCKET) {
+    perror("socket");
+    return false;
+  }
+  int yes = 1;
+  setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char *)&yes,
+             sizeof(yes));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if (bind(listener, (struct sockaddr *)&addr, sizeof(addr)) ||
+      listen(listener, 1)) {
+    fprintf(stderr, "Could not listen on port %u: ", port);
+    perror(NULL);
+    closesocket(listener);
+    return false;
+  }
+
+  fprintf(stderr, "Waiting for GDB connection on localhost:%u\n", port);
+  *fd = accept(listener, NULL, NULL);
+  closesocket(listener);
+  if (*fd == INVALID_SOCKET) {
+    perror("accept");
+    return false;
+  }
+  setsockopt(*fd, IPPROTO_TCP, TCP_NODELAY, (const char *)&yes, sizeof(yes));
+  return true;
+}
+
+bool gdbServe(struct machine *m, unsigned port) {
+  static struct gdbConnection conn;
+  struct gdbConnection *g = &conn;
+  if (!acceptConnection(port, &g->fd))
+    return false;
+
+  static char packet[MAX_PACKET];
+  static char reply[2 * MAX_PACKET];
+  char lastStop[32];
+  sprintf(lastStop, "S%02x", SIGTRAP_);
+  struct cpu6502 *c = &m->cpu;
+  bool done = false;
+
+  while (!done && receivePacket(g, packet)) {
+    reply[0] = '\0';
+    char *args = packet + 1;
+    switch (packet[0]) {
+    case '?':
+      strcpy(reply, lastStop);
+      break;
+
+    case 'g': {
+      uint8_t regs[NUM_REGS + 1];
+      readRegisters(c, regs);
+      for (size_t i = 0; i < sizeof(regs); ++i)
+        sprintf(reply + 2 * i, "%02x", regs[i]);
+      break;
+    }
+
+    case 'G': {
+      uint8_t regs[NUM_REGS + 1];
+      if (strlen(args) != 2 * sizeof(regs) ||
+          !parseHexBytes(args, regs, sizeof(regs))) {
+        strcpy(reply, "E01");
+        break;
+      }
+      writeRegisters(c, regs);
+      strcpy(reply, "OK");
+      break;
+    }
+
+    case 'p':
+    case 'P': {
+      char *end;
+      int offset, size;
+      unsigned long n = strtoul(args, &end, 16);
+      if (!registerSlot(n, &offset, &size)) {
+        strcpy(reply, "E01");
+        break;
+      }
+      uint8_t regs[NUM_REGS + 1];
+      readRegisters(c, regs);
+      if (packet[0] == 'p') {
+        for (int i = 0; i < size; ++i)
+          sprintf(reply + 2 * i, "%02x", regs[offset + i]);
+        break;
+      }
+      if (*end != '=' || strlen(end + 1) != 2 * (size_t)size ||
+          !parseHexBytes(end + 1, &regs[offset], size)) {
+        strcpy(reply, "E01");
+        break;
+      }
+      writeRegisters(c, regs);
+      strcpy(reply, "OK");
+      break;
+    }
+
+    case 'm':
+    case 'M': {
+      // Memory is accessed directly, without I/O side effects.
+      char *end;
+      unsigned long addr = strtoul(args, &end, 16);
+      unsigned long len = *end == ',' ? strtoul(end + 1, &end, 16) : 0;
+      if (addr + len > 65536 || len > MAX_PACKET / 2 - 1) {
+        strcpy(reply, "E01");
+        break;
+      }
+      if (packet[0] == 'm') {
+        for (unsigned long i = 0; i < len; ++i)
+          sprintf(reply + 2 * i, "%02x", m->memory[addr + i]);
+        break;
+      }
+      if (*end != ':' || strlen(end + 1) != 2 * len ||
+          !parseHexBytes(end + 1, &m->memory[addr], len)) {
+        strcpy(reply, "E01");
+        break;
+      }
+      strcpy(reply, "OK");
+      break;
+    }
+
+    case 'c':
+    case 's':
+      if (*args)
+        c->pc = strtoul(args, NULL, 16);
+      resume(g, m, packet[0] == 's', lastStop);
+      strcpy(reply, lastStop);
+      done = m->state == EXITED || m->state == ABORTED;
+      break;
+
+    case 'Z':
+    case 'z': {
+      bool set = packet[0] == 'Z';
+      char *end;
+      unsigned long type = strtoul(args, &end, 16);
+      unsigned long addr = *end == ',' ? strtoul(end + 1, &end, 16) : 65536;
+      unsigned long len = *end == ',' ? strtoul(end + 1, &end, 16) : 1;
+      if (addr >= 65536 || addr + len > 65536)
+        strcpy(reply, "E01");
+      else if (type <= 1) {
+        setBreakpoint(addr, set);
+        strcpy(reply, "OK");
+      } else if (type <= 4) {
+        uint8_t kind = type == 2   ? WATCH_WRITE
+                       : type == 3 ? WATCH_READ
+                                   : WATCH_READ | WATCH_WRITE;
+        for (unsigned long i = 0; i < len; ++i)
+          setWatchpoint(m, addr + i, kind, set);
+        strcpy(reply, "OK");
+      }
+      break;
+    }
+
+    case 'q':
+      if (!strncmp(packet, "qSupported", 10))
+        sprintf(reply, "PacketSize=%x;qXfer:features:read+", MAX_PACKET);
+      else if (!strcmp(packet, "qAttached"))
+        strcpy(reply, "1");
+      else if (!strncmp(packet, xferPrefix, sizeof(xferPrefix) - 1)) {
+        char *end;
+        unsigned long offset =
+            strtoul(packet + sizeof(xferPrefix) - 1, &end, 16);
+        unsigned long len = *end == ',' ? strtoul(end + 1, NULL, 16) : 0;
+        size_t total = sizeof(targetXml) - 1;
+        if (offset >= total) {
+          strcpy(reply, "l");
+          break;
+        }
+        if (len > MAX_PACKET - 2)
+          len = MAX_PACKET - 2;
+        bool last = offset + len >= total;
+        if (last)
+          len = total - offset;
+        reply[0] = last ? 'l' : 'm';
+        memcpy(reply + 1, targetXml + offset, len);
+        reply[len + 1] = '\0';
+      }
+      break;
+
+    case 'H':
+      strcpy(reply, "OK");
+      break;
+
+    case 'D':
+      strcpy(reply, "OK");
+      done = true;
+      break;
+
+    case 'k':
+      m->state = EXITED;
+      m->exitCode = 1;
+      done = true;
+      break;
+    }
+
+    if (packet[0] != 'k')
+      sendPacket(g, reply);
+  }
+
+  closesocket(g->fd);
+  // Detached or disconnected; let the program run on undisturbed.
+  if (m->state == WATCHPOINT_HIT)
+    m->state = RUNNING;
+  free(m->watchpoints);
+  m->watchpoints = NULL;
+  memset(m->readWatches, 0, sizeof(m->readWatches));
+  memset(m->writeWatches, 0, sizeof(m->writeWatches));
+  for (int page = 0; page < 256; ++page)
+    mapPage(m, page);
+  return true;
+}
@@ -0,0 +1,220 @@
+// High-level emulation of runtime routines for mos-sim --hle.
+//
+// When the PC reaches the entry point of a known routine, the host computes
+// its result directly and returns to the caller as if through RTS. Arguments
+// and results follow the llvm-mos C calling convention: pointers go in the
+// first free pair of __rc2/__rc3 through __rc14/__rc15, and every other
+// argument is split into bytes that go in A, X, then the first free of
+// __rc2 through __rc15, in argument order. Results use the same registers as
+// a first argument of the same type.
+
+#include <stdlib.h>
+
+#include "mos-sim.h"
+#include "symbols.h"
+
+enum routineKind {
+  MEMCPY,
+  MEMMOVE,
+  MEMSET,
+  // __memset(char *, char, size_t), called by memset and by the compiler.
+  MEMSET_CHAR,
+  STRLEN,
+  MUL,
+  DIV,
+  MOD,
+  DIVMOD,
+};
+
+struct routine {
+  const char *name;
+  enum routineKind kind;
+  // Operand size in bytes and signedness, for arithmetic.
+  uint8_t size;
+  bool isSigned;
+};
+
+// The 64-bit divmod routines are left out; their remainder pointer does not
+// fit in registers.
+static const struct routine routines[] = {
+    {"memcpy", MEMCPY},          {"memmove", MEMMOVE},
+    {"memset", MEMSET},          {"__memset", MEMSET_CHAR},
+    {"strlen", STRLEN},          {"__mulqi3", MUL, 1},
+    {"__mulhi3", MUL, 2},        {"__mulsi3", MUL, 4},
+    {"__muldi3", MUL, 8},        {"__udivqi3", DIV, 1},
+    {"__udivhi3", DIV, 2},       {"__udivsi3", DIV, 4},
+    {"__udivdi3", DIV, 8},       {"__umodqi3", MOD, 1},
+    {"__umodhi3", MOD, 2},       {"__umodsi3", MOD, 4},
+    {"__umoddi3", MOD, 8},       {"__udivmodqi4", DIVMOD, 1},
+    {"__udivmodhi4", DIVMOD, 2}, {"__udivmodsi4", DIVMOD, 4},
+    {"__divqi3", DIV, 1, true},  {"__divhi3", DIV, 2, true},
+    {"__divsi3", DIV, 4, true},  {"__divdi3", DIV, 8, true},
+    {"__modqi3", MOD, 1, true},  {"__modhi3", MOD, 2, true},
+    {"__modsi3", MOD, 4, true},  {"__moddi3", MOD, 8, true},
+    {"__divmodqi4", DIVMOD, 1, true}, {"__divmodhi4", DIVMOD, 2, true},
+    {"__divmodsi4", DIVMOD, 4, true},
+};
+
+struct hle {
+  // Index into routines plus one for each address; zero if none.
+  uint8_t routineAt[65536];
+  // Address of __rc0.
+  uint16_t rc0;
+  uint32_t cycles;
+};
+
+struct hle *newHle(const struct symbolTable *symbols, uint32_t cycles) {
+  struct hle *h = calloc(1, sizeof(struct hle));
+  if (!h) {
+    perror("calloc");
+    exit(1);
+  }
+  const struct symbol *rc0 = lookupSymbol(symbols, "__rc0");
+  h->rc0 = rc0 ? rc0->address : 0;
+  h->cycles = cycles;
+  for (size_t i = 0; i < sizeof(routines) / sizeof(routines[0]); ++i) {
+    const struct symbol *sym = lookupSymbol(symbols, routines[i].name);
+    if (sym && sym->address < 65536)
+      h->routineAt[sym->address] = i + 1;
+  }
+  return h;
+}
+
+// Memory accesses honor the memory map, so I/O, watchpoints and memory
+// statistics behave as if the routine had run.
+static uint8_t peek(struct machine *m, uint16_t address) {
+  struct cpu6502 *c = &m->cpu;
+  const uint8_t *page = c->readmap[address >> 8];
+  return page ? page[address & 0xff] : c->read(c, address);
+}
+
+static void poke(struct machine *m, uint16_t address, uint8_t value) {
+  struct cpu6502 *c = &m->cpu;
+  uint8_t *page = c->writemap[address >> 8];
+  if (page)
+    page[address & 0xff] = value;
+  else
+    c->write(c, address, value);
+}
+
+// Byte slot i of the argument registers: A, X, then __rc2 onwards.
+static uint8_t *slot(struct machine *m, unsigned i) {
+  if (i == 0)
+    return &m->cpu.a;
+  if (i == 1)
+    return &m->cpu.x;
+  return &m->memory[(m->hle->rc0 + i) & 0xff];
+}
+
+static uint64_t getInt(struct machine *m, unsigned first, unsigned size,
+                       bool isSigned) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < size; ++i)
+    value |= (uint64_t)*slot(m, first + i) << i * 8;
+  if (isSigned && size < 8 && value >> (size * 8 - 1))
+    value |= ~(uint64_t)0 << size * 8;
+  return value;
+}
+
+static void setInt(struct machine *m, unsigned first, unsigned size,
+                   uint64_t value) {
+  for (unsigned i = 0; i < size; ++i)
+    *slot(m, first + i) = value >> i * 8;
+}
+
+// Pointer register pair __rcN/__rcN+1.
+static uint16_t getPointer(struct machine *m, unsigned rc) {
+  return getInt(m, rc, 2, false);
+}
+
+// Computes the routine's result. Returns false to run it normally instead,
+// for cases that are undefined in C or whose result depends on the
+// implementation.
+static bool emulate(struct machine *m, const struct routine *r) {
+  switch (r->kind) {
+  case MEMCPY: {
+    uint16_t dest = getPointer(m, 2), src = getPointer(m, 4);
+    for (uint16_t n = getInt(m, 0, 2, false); n; --n)
+      poke(m, dest++, peek(m, src++));
+    return true;
+  }
+  case MEMMOVE: {
+    uint16_t dest = getPointer(m, 2), src = getPointer(m, 4);
+    uint16_t n = getInt(m, 0, 2, false);
+    if (dest <= src) {
+      for (; n; --n)
+        poke(m, dest++, peek(m, src++));
+    } else {
+      while (n--)
+        poke(m, dest + n, peek(m, src + n));
+    }
+    return true;
+  }
+  case MEMSET:
+  case MEMSET_CHAR: {
+    uint16_t ptr = getPointer(m, 2);
+    uint8_t value = m->cpu.a;
+    uint16_t n = r->kind == MEMSET ? getInt(m, 4, 2, false)
+                                   : m->cpu.x | *slot(m, 4) << 8;
+    for (; n; --n)
+      poke(m, ptr++, value);
+    return true;
+  }
+  case STRLEN: {
+    uint16_t s = getPointer(m, 2), len = 0;
+    while (peek(m, s + len))
+      if (!++len)
+        return false;
+    setInt(m, 0, 2, len);
+    return true;
+  }
+  case MUL:
+    setInt(m, 0, r->size,
+           getInt(m, 0, r->size, false) * getInt(m, r->size, r->size, false));
+    return true;
+  case DIV:
+  case MOD:
+  case DIVMOD: {
+    uint64_t a = getInt(m, 0, r->size, r->isSigned);
+    uint64_t b = getInt(m, r->size, r->size, r->isSigned);
+    uint64_t quotient, remainder;
+    if (!b)
+      return false;
+    if (r->isSigned) {
+      int64_t sa = (int64_t)a, sb = (int64_t)b;
+      // The most negative value divided by -1 overflows.
+      if (sb == -1 && a == ~(uint64_t)0 << (r->size * 8 - 1))
+        return false;
+      quotient = (uint64_t)(sa / sb);
+      remainder = (uint64_t)(sa % sb);
+    } else {
+      quotient = a / b;
+      remainder = a % b;
+    }
+    setInt(m, 0, r->size, r->kind == MOD ? remainder : quotient);
+    if (r->kind == DIVMOD) {
+      // The remainder pointer is in the first pair after both operands.
+      uint16_t rem = getPointer(m, 2 * r->size);
+      for (unsigned i = 0; i < r->size; ++i)
+        poke(m, rem + i, remainder >> i * 8);
+    }
+    return true;
+  }
+  }
+  return false;
+}
+
+bool emulateRoutine(struct machine *m) {
+  struct cpu6502 *c = &m->cpu;
+  uint8_t index = m->hle->routineAt[c->pc];
+  if (!index || !emulate(m, &routines[index - 1]))
+    return false;
+  // Return as RTS would.
+  uint16_t ret = m->memory[0x100 + (uint8_t)(c->sp + 1)] |
+                 m->memory[0x100 + (uint8_t)(c->sp + 2)] << 8;
+  c->sp += 2;
+  c->pc = ret + 1;
+  c->clockticks6502 += m->hle->cycles;
+  ++c->instructions;
+  return true;
+}
@@ -0,0 +1,153 @@
+// Memory access statistics for mos-sim --memory-report.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mos-sim.h"
+#include "symbols.h"
+
+// Instructions to wait after a write to the low byte of the soft stack
+// pointer before trusting its value. Adjusting the pointer writes the low
+// byte first, then possibly the high byte a few instructions later; in
+// between, the pointer can read up to 256 bytes too low.
+#define SOFT_STACK_SETTLE 4
+
+struct memoryStats {
+  uint32_t reads[65536], writes[65536], executes[65536];
+  uint8_t minSp;
+  // Address of __rc0, the low byte of the soft stack pointer.
+  uint16_t rc0;
+  uint16_t softSp, minSoftSp;
+  bool haveSoftSp;
+  uint8_t settle;
+  // -1 if unknown or never touched.
+  int32_t heapStart, heapMax;
+};
+
+struct memoryStats *newMemoryStats(const struct symbolTable *symbols) {
+  struct memoryStats *s = calloc(1, sizeof(struct memoryStats));
+  if (!s) {
+    perror("calloc");
+    exit(1);
+  }
+  s->minSp = 0xff;
+  s->minSoftSp = 0xffff;
+  s->heapMax = -1;
+  const struct symbol *rc0 = lookupSymbol(symbols, "__rc0");
+  s->rc0 = rc0 ? rc0->address : 0;
+  const struct symbol *heap = lookupSymbol(symbols, "__heap_start");
+  s->heapStart = heap ? (int32_t)heap->address : -1;
+  return s;
+}
+
+static void sampleSoftStack(struct machine *m) {
+  struct memoryStats *s = m->stats;
+  s->softSp = m->memory[s->rc0] | m->memory[(s->rc0 + 1) & 0xffff] << 8;
+  s->haveSoftSp = true;
+  if (s->softSp < s->minSoftSp)
+    s->minSoftSp = s->softSp;
+}
+
+void noteRead(struct machine *m, uint16_t address) {
+  ++m->stats->reads[address];
+}
+
+void noteWrite(struct machine *m, uint16_t address) {
+  struct memoryStats *s = m->stats;
+  ++s->writes[address];
+  if (address == s->rc0) {
+    s->settle = SOFT_STACK_SETTLE;
+  } else if (address == ((s->rc0 + 1) & 0xffff)) {
+    s->settle = 0;
+    sampleSoftStack(m);
+  } else if (s->heapStart >= 0 && address >= s->heapStart && s->haveSoftSp &&
+             address < s->softSp && address > s->heapMax) {
+    // Below the soft stack pointer, so not part of any stack frame.
+    s->heapMax = address;
+  }
+}
+
+void noteInstruction(struct machine *m) {
+  struct memoryStats *s = m->stats;
+  ++s->executes[m->cpu.pc];
+  if (m->cpu.sp < s->minSp)
+    s->minSp = m->cpu.sp;
+  if (s->settle && !--s->settle)
+    sampleSoftStack(m);
+}
+
+static void printValue(FILE *file, const char *key, int32_t value) {
+  if (value < 0)
+    fprintf(file, "%s -\n", key);
+  else
+    fprintf(file, "%s %04x\n", key, value);
+}
+
+static void printCounts(FILE *file, const struct memoryStats *s,
+                        const char *kind, const char *name, uint32_t begin,
+                        uint32_t end) {
+  uint64_t reads = 0, writes = 0, executes = 0;
+  for (uint32_t a = begin; a < end; ++a) {
+    reads += s->reads[a];
+    writes += s->writes[a];
+    executes += s->executes[a];
+  }
+  if (reads || writes || executes)
+    fprintf(file, "%s %s reads %llu writes %llu executes %llu\n", kind, name,
+            (unsigned long long)reads, (unsigned long long)writes,
+            (unsigned long long)executes);
+}
+
+bool writeMemoryReport(const struct machine *m,
+                       const struct symbolTable *symbols,
+                       const char *filename) {
+  const struct memoryStats *s = m->stats;
+  FILE *file = fopen(filename, "w");
+  if (!file) {
+    fprintf(stderr, "Could not open '%s': ", filename);
+    perror(NULL);
+    return false;
+  }
+
+  fputs("# mos-sim memory report\n", file);
+  printValue(file, "sp-min", s->minSp);
+  printValue(file, "soft-stack-min", s->haveSoftSp ? s->minSoftSp : -1);
+  printValue(file, "heap-start", s->heapStart);
+  printValue(file, "heap-max", s->heapMax);
+
+  for (uint32_t page = 0; page < 256; ++page) {
+    char name[3];
+    snprintf(name, sizeof(name), "%02x", page);
+    printCounts(file, s, "page", name, page << 8, (page + 1) << 8);
+  }
+
+  // Each symbol covers its size if known, otherwise everything up to the
+  // next symbol. Absolute symbols are constants, not storage.
+  for (size_t i = 0; i < symbols->count; ++i) {
+    const struct symbol *sym = &symbols->symbols[i];
+    if (sym->type == 'a' || sym->type == 'A' || sym->address >= 65536)
+      continue;
+    uint32_t end = 65536;
+    if (sym->size) {
+      end = sym->address + sym->size;
+    } else {
+      for (size_t j = i + 1; j < symbols->count; ++j) {
+        const struct symbol *next = &symbols->symbols[j];
+        if (next->type != 'a' && next->type != 'A' &&
+            next->address > sym->address) {
+          end = next->address;
+          break;
+        }
+      }
+    }
+    printCounts(file, s, "symbol", sym->name, sym->address,
+                end < 65536 ? end : 65536);
+  }
+
+  if (fclose(file)) {
+    fprintf(stderr, "Error writing '%s': ", filename);
+    perror(NULL);
+    return false;
+  }
+  return true;
+}
@@ -1,10 +1,19 @@
+#include <dirent.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
+#include "elf.h"
+#include "fake6502.h"
+#include "mos-sim.h"
+#include "sim-trace.h"
+#include "symbols.h"
 #include "types.h"
 
 #define TRACE 0
@@ -14,10 +23,13 @@ const float kMHz = 10;
 
 static const char usage[] =
     "Usage: sim [OPTIONS] [image]\n"
+    "       sim [OPTIONS] --batch DIR|MANIFEST\n"
     "\n"
     "6502 simulator.\n"
     "\n"
-    "Takes a memory image file.\n"
+    "Takes an ELF executable or a memory image file. ELF executables are\n"
+    "loaded by their PT_LOAD segments, and provide symbols as if given\n"
+    "with --symbols.\n"
     "The image file is a collection of blocks. Each block consists of a\n"
     "16-bit starting address, then a 16-bit block size, then that many bytes\n"
     "of contents. Both the address and size are stored little-endian.\n"
@@ -25,6 +37,16 @@ static const char usage[] =
     "The simulated 6502 will execute a reset sequence through the vector at\n"
     "$FFFC like a real 6502.\n"
     "\n"
+    "$FFE0-$FFE5 hold a programmable timer:\n"
+    "\t$FFE0-$FFE3: Period in cycles, little-endian.\n"
+    "\t$FFE4: Control. Bit 0 enables the timer, bit 1 raises NMI instead\n"
+    "\t\tof IRQ, and bit 2 makes it fire only once. Writing it with bit\n"
+    "\t\t0 set (re)starts the countdown from the current period.\n"
+    "\t$FFE5: Status. Bit 0 is set when the timer fires and holds IRQ\n"
+    "\t\tasserted; any write clears it.\n"
+    "Reading $FFF0 latches the cycle count into $FFF0-$FFF3; writing it\n"
+    "resets the count.\n"
+    "Writing to $FFF4 requests a state snapshot (see --save-state).\n"
     "Writing to $FFF7 aborts.\n"
     "Writing to $FFF8 quits normally.\n"
     "Writing to $FFF9 writes to stdout.\n"
@@ -32,159 +54,841 @@ static const char usage[] =
     "OPTIONS:\n"
     "\t--cycles: Print cycle count to stderr.\n"
     "\t--trace: Print each instruction address to stderr.\n"
+    "\t--trace-file FILE: Write a compact binary trace of each instruction\n"
+    "\t\tto FILE. Use mos-trace to convert it to text.\n"
     "\t--profile: Print number of cycles executed at each PC address.\n"
-    "\t--cmos: Enable 65C02 emulation.\n";
+    "\t--cmos: Enable 65C02 emulation.\n"
+    "\t--symbols FILE: Read program symbols from an ELF file, or from\n"
+    "\t\tFILE in the format produced by llvm-nm (optionally with -S).\n"
+    "\t--memory-report FILE: On exit, write memory usage to FILE: the\n"
+    "\t\tminimum hardware and soft (__rc0/__rc1) stack pointers, the\n"
+    "\t\thighest heap address written (from __heap_start), and read,\n"
+    "\t\twrite and execute counts per 256-byte page and per symbol.\n"
+    "\t\tReads include instruction fetches. Symbol based entries need\n"
+    "\t\t--symbols.\n"
+    "\t--save-state FILE: When a snapshot is requested, save the memory and\n"
+    "\t\tCPU state to FILE and exit.\n"
+    "\t--save-state-on-write ADDR: Request a snapshot on any write to the\n"
+    "\t\tgiven hexadecimal address, in addition to $FFF4.\n"
+    "\t--load-state FILE: Resume from a state saved by --save-state\n"
+    "\t\tinstead of loading an image and resetting.\n"
+    "\t--hle: Emulate calls to known runtime routines (memcpy, memmove,\n"
+    "\t\tmemset, strlen, and integer multiplication and division) on\n"
+    "\t\tthe host instead of simulating them. Routines are found by\n"
+    "\t\tname from the symbols. Cycle counts are no longer exact.\n"
+    "\t--hle-cycles N: Cycles charged for each emulated call. Defaults to\n"
+    "\t\t6, the cost of the return alone.\n"
+    "\t--gdb PORT: Wait for a GDB remote protocol connection on the given\n"
+    "\t\tlocal TCP port before starting, and run under its control.\n"
+    "\t--batch DIR|MANIFEST: Run every ELF executable or image in a\n"
+    "\t\tdirectory, or every one listed one per line in a manifest file.\n"
+    "\t\tIn a directory, an ELF file next to an image of the same name\n"
+    "\t\twithout \".elf\" is skipped. Each image runs with\n"
+    "\t\tempty input; its exit code, cycle count and output are written\n"
+    "\t\tto stdout in order as one report.\n"
+    "\t--jobs N: Number of images to run in parallel in batch mode.\n"
+    "\t\tDefaults to the number of online processors.\n";
 
-void reset6502(uint8_t cmos);
-void step6502();
-extern uint32_t clockticks6502;
-extern uint16_t pc;
-extern uint8_t a, x, y, sp, status;
-
-uint8_t memory[65536];
-uint32_t clock_start = 0;
 bool shouldPrintCycles = false;
 bool shouldTrace = false;
+const char *traceFile = NULL;
+const char *symbolsFile = NULL;
+const char *memoryReportFile = NULL;
+struct symbolTable symbols;
 bool shouldProfile = false;
 bool cmos = false;
-bool input_eof = false;
+const char *saveStateFile = NULL;
+const char *loadStateFile = NULL;
+int32_t saveStateAddress = -1;
+const char *batchPath = NULL;
+int jobs = 0;
+unsigned gdbPort = 0;
+bool hle = false;
+uint32_t hleCycles = 6;
 
-uint32_t clockTicksAtAddress[65536];
+static void bufferPut(struct buffer *b, char c) {
+  if (b->size == b->capacity) {
+    b->capacity = b->capacity ? b->capacity * 2 : 256;
+    b->data = realloc(b->data, b->capacity);
+    if (!b->data) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  b->data[b->size++] = c;
+}
 
-int8_t read6502(uint16_t address) {
+// Buffered writer for --trace-file.
+struct traceWriter {
+  FILE *file;
+  const char *filename;
+  size_t used;
+  uint8_t buf[1 << 20];
+};
+
+static void traceFlush(struct traceWriter *t) {
+  if (t->used && fwrite(t->buf, t->used, 1, t->file) != 1) {
+    fprintf(stderr, "Error writing trace file '%s': ", t->filename);
+    perror(NULL);
+    exit(1);
+  }
+  t->used = 0;
+}
+
+struct traceWriter *traceOpen(const char *filename, uint32_t clockticks) {
+  struct traceWriter *t = malloc(sizeof(struct traceWriter));
+  if (!t) {
+    perror("malloc");
+    exit(1);
+  }
+  t->file = fopen(filename, "wb");
+  if (!t->file) {
+    fprintf(stderr, "Could not open '%s': ", filename);
+    perror(NULL);
+    exit(1);
+  }
+  t->filename = filename;
+  memset(t->buf, 0, TRACE_HEADER_SIZE);
+  memcpy(t->buf, TRACE_MAGIC, 8);
+  t->buf[8] = TRACE_VERSION;
+  t->buf[9] = TRACE_RECORD_SIZE;
+  for (int i = 0; i < 4; ++i)
+    t->buf[12 + i] = clockticks >> i * 8;
+  t->used = TRACE_HEADER_SIZE;
+  return t;
+}
+
+void traceClose(struct traceWriter *t) {
+  traceFlush(t);
+  if (fclose(t->file)) {
+    fprintf(stderr, "Error writing trace file '%s': ", t->filename);
+    perror(NULL);
+    exit(1);
+  }
+  free(t);
+}
+
+// Starts a record with the registers before an instruction. Returns where
+// traceEnd should put the instruction's cycle delta.
+static uint8_t *traceBegin(struct traceWriter *t, const struct cpu6502 *c) {
+  // Leave room for an extension record.
+  if (t->used + 2 * TRACE_RECORD_SIZE > sizeof(t->buf))
+    traceFlush(t);
+  uint8_t *r = &t->buf[t->used];
+  r[0] = c->pc & 0xff;
+  r[1] = c->pc >> 8;
+  r[2] = c->a;
+  r[3] = c->x;
+  r[4] = c->y;
+  r[5] = c->sp;
+  r[6] = c->status;
+  t->used += TRACE_RECORD_SIZE;
+  return &r[7];
+}
+
+static void traceEnd(struct traceWriter *t, uint8_t *delta, uint32_t cycles) {
+  if (cycles < TRACE_DELTA_EXTENDED) {
+    *delta = cycles;
+    return;
+  }
+  *delta = TRACE_DELTA_EXTENDED;
+  uint8_t *r = &t->buf[t->used];
+  memset(r, 0, TRACE_RECORD_SIZE);
+  for (int i = 0; i < 4; ++i)
+    r[i] = cycles >> i * 8;
+  t->used += TRACE_RECORD_SIZE;
+}
+
+static void checkWatchpoint(struct machine *m, uint16_t address,
+                            uint8_t kind) {
+  if (m->watchpoints[address] & kind && m->state == RUNNING) {
+    m->state = WATCHPOINT_HIT;
+    m->watchAddress = address;
+    m->watchKind = kind;
+  }
+}
+
+// Handles the accesses the CPU's memory map does not cover: the I/O page,
+// any sentinel address, and pages with watchpoints.
+static uint8_t readIO(struct cpu6502 *c, uint16_t address) {
+  struct machine *m = c->user;
+  if (m->watchpoints)
+    checkWatchpoint(m, address, WATCH_READ);
+  if (m->stats)
+    noteRead(m, address);
   if (address == 0xfff0) {
-    *((uint32_t *)(memory + address)) = clockticks6502 - clock_start;
+    uint32_t clock = c->clockticks6502 - m->clock_start;
+    for (int i = 0; i < 4; ++i)
+      m->memory[address + i] = clock >> i * 8;
+  } else if (address == 0xffe5) {
+    return m->timerPending;
   } else if (address == 0xfff5) {
-    const int c = getchar();
-    input_eof = (c == EOF);
-    return (int8_t)c;
+    const int ch = m->input ? getc(m->input) : EOF;
+    m->input_eof = (ch == EOF);
+    return (uint8_t)ch;
   } else if (address == 0xfff6) {
-    return (int8_t)input_eof;
+    return (uint8_t)m->input_eof;
   }
-  return memory[address];
-}
-
-void finish(void) {
-  if (shouldPrintCycles)
-    fprintf(stderr, "%d cycles\n", clockticks6502);
-  if (shouldProfile)
-    for (int addr = 0; addr < 65536; ++addr)
-      if (clockTicksAtAddress[addr])
-        fprintf(stderr, "%04x %d\n", addr, clockTicksAtAddress[addr]);
+  return m->memory[address];
 }
 
-void write6502(uint16_t address, uint8_t value) {
+static void writeIO(struct cpu6502 *c, uint16_t address, uint8_t value) {
+  struct machine *m = c->user;
+  if (m->watchpoints)
+    checkWatchpoint(m, address, WATCH_WRITE);
+  if (address == saveStateAddress && m->state == RUNNING)
+    m->state = SNAPSHOT_REQUESTED;
   switch (address) {
   default:
-    memory[address] = value;
+    m->memory[address] = value;
+    break;
+  case 0xFFE4: {
+    const uint8_t *period = &m->memory[0xffe0];
+    m->memory[address] = value;
+    m->timerPeriod = period[0] | period[1] << 8 | period[2] << 16 |
+                     (uint32_t)period[3] << 24;
+    m->timerControl = m->timerPeriod ? value : value & ~TIMER_ENABLE;
+    m->timerNext = c->clockticks6502 + m->timerPeriod;
+    break;
+  }
+  case 0xFFE5:
+    m->timerPending = false;
     break;
   case 0xFFF0:
-    clock_start = clockticks6502;
+    m->clock_start = c->clockticks6502;
+    break;
+  case 0xFFF4:
+    if (m->state == RUNNING)
+      m->state = SNAPSHOT_REQUESTED;
     break;
   case 0xFFF7:
-    finish();
-    abort();
+    m->state = ABORTED;
+    m->haltClockticks = c->clockticks6502;
+    break;
   case 0xFFF8:
-    finish();
-    exit(value);
+    m->state = EXITED;
+    m->exitCode = value;
+    m->haltClockticks = c->clockticks6502;
+    break;
   case 0xFFF9:
-    putchar(value);
+    if (m->output)
+      bufferPut(m->output, value);
+    else
+      putchar(value);
     break;
   }
+  if (m->stats)
+    noteWrite(m, address);
+}
+
+struct machine *newMachine(void) {
+  struct machine *m = calloc(1, sizeof(struct machine));
+  if (!m) {
+    perror("calloc");
+    exit(1);
+  }
+  init6502(&m->cpu, readIO, writeIO, m);
+  if (memoryReportFile)
+    m->stats = newMemoryStats(&symbols);
+  if (hle)
+    m->hle = newHle(&symbols, hleCycles);
+  for (int page = 0; page < 256; ++page)
+    mapPage(m, page);
+
+  if (shouldProfile) {
+    m->clockTicksAtAddress = calloc(65536, sizeof(uint32_t));
+    if (!m->clockTicksAtAddress) {
+      perror("calloc");
+      exit(1);
+    }
+  }
+  return m;
+}
+
+void mapPage(struct machine *m, uint8_t page) {
+  // Everything below the I/O page is plain RAM.
+  bool ram = page != 0xff && !m->stats;
+  uint8_t *memory = &m->memory[page << 8];
+  m->cpu.readmap[page] = ram && !m->readWatches[page] ? memory : NULL;
+  m->cpu.writemap[page] = ram && !m->writeWatches[page] &&
+                                  (saveStateAddress < 0 ||
+                                   saveStateAddress >> 8 != page)
+                              ? memory
+                              : NULL;
+}
+
+void freeMachine(struct machine *m) {
+  free(m->clockTicksAtAddress);
+  free(m->watchpoints);
+  free(m->stats);
+  free(m->hle);
+  free(m);
+}
+
+// Fires the timer when due and delivers its interrupt. NMI is edge
+// triggered, so it is taken once per firing; IRQ is taken whenever the
+// timer is pending and interrupts are enabled.
+static void updateTimer(struct machine *m) {
+  struct cpu6502 *c = &m->cpu;
+  if (m->timerControl & TIMER_ENABLE &&
+      (int32_t)(c->clockticks6502 - m->timerNext) >= 0) {
+    if (m->timerControl & TIMER_ONE_SHOT)
+      m->timerControl &= ~TIMER_ENABLE;
+    else
+      m->timerNext += m->timerPeriod;
+    m->timerPending = true;
+    if (m->timerControl & TIMER_NMI) {
+      nmi6502(c);
+      return;
+    }
+  }
+  if (m->timerPending && !(m->timerControl & TIMER_NMI) &&
+      !(c->status & FLAG_INTERRUPT))
+    irq6502(c);
+}
+
+static inline void step(struct machine *m) {
+  struct cpu6502 *c = &m->cpu;
+  if (shouldTrace)
+    fprintf(stderr, "%04x a:%02x x:%02x y:%02x s: %02x st:%02x\n", c->pc,
+            c->a, c->x, c->y, c->sp, c->status);
+  uint8_t *traceDelta = m->trace ? traceBegin(m->trace, c) : NULL;
+  uint32_t clockTicksBefore = c->clockticks6502;
+  uint16_t addr = c->pc;
+  if (m->stats)
+    noteInstruction(m);
+  if (!m->hle || !emulateRoutine(m))
+    step6502(c);
+  // The program stops at the exit write; the rest of that instruction's
+  // cycles are not counted.
+  if (m->state == EXITED || m->state == ABORTED)
+    c->clockticks6502 = m->haltClockticks;
+  // Interrupts are checked between instructions; the entry sequence's cycles
+  // count towards the instruction before it.
+  else if (m->timerControl & TIMER_ENABLE || m->timerPending)
+    updateTimer(m);
+  if (traceDelta)
+    traceEnd(m->trace, traceDelta, c->clockticks6502 - clockTicksBefore);
+  if (m->clockTicksAtAddress)
+    m->clockTicksAtAddress[addr] += c->clockticks6502 - clockTicksBefore;
+}
+
+void stepMachine(struct machine *m) { step(m); }
+
+// Executes instructions until the machine leaves the RUNNING state.
+void run(struct machine *m) {
+  while (m->state == RUNNING)
+    step(m);
+}
+
+void finish(struct machine *m) {
+  if (m->trace) {
+    traceClose(m->trace);
+    m->trace = NULL;
+  }
+  if (shouldPrintCycles)
+    fprintf(stderr, "%d cycles\n", m->cpu.clockticks6502);
+  if (m->stats)
+    writeMemoryReport(m, &symbols, memoryReportFile);
+  if (m->clockTicksAtAddress)
+    for (int addr = 0; addr < 65536; ++addr)
+      if (m->clockTicksAtAddress[addr])
+        fprintf(stderr, "%04x %d\n", addr, m->clockTicksAtAddress[addr]);
+}
+
+// State file layout. All multi-byte values are little-endian.
+//   0: Magic "MOSSIMST"
+//   8: Version (1 byte)
+//   9: Flags (1 byte; bit 0: 65C02 emulation, bit 1: input EOF seen)
+//  10: pc (2 bytes), a, x, y, sp, status (1 byte each)
+//  17: clockticks6502, clock_start (4 bytes each)
+//  25: timerPeriod, timerNext (4 bytes each), timerControl (1 byte)
+//  34: Timer flags (1 byte; bit 0: pending)
+//  35: memory (65536 bytes)
+static const char stateMagic[8] = "MOSSIMST";
+static const uint8_t stateVersion = 2;
+#define STATE_HEADER_SIZE 35
+
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+}
+static void put32(uint8_t *p, uint32_t v) {
+  put16(p, v & 0xffff);
+  put16(p + 2, v >> 16);
+}
+static uint16_t get16(const uint8_t *p) { return p[0] | p[1] << 8; }
+static uint32_t get32(const uint8_t *p) {
+  return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+bool saveState(const struct machine *m, const char *filename) {
+  const struct cpu6502 *c = &m->cpu;
+  uint8_t header[STATE_HEADER_SIZE];
+  memcpy(header, stateMagic, sizeof(stateMagic));
+  header[8] = stateVersion;
+  header[9] = (cmos ? 1 : 0) | (m->input_eof ? 2 : 0);
+  put16(header + 10, c->pc);
+  header[12] = c->a;
+  header[13] = c->x;
+  header[14] = c->y;
+  header[15] = c->sp;
+  header[16] = c->status;
+  put32(header + 17, c->clockticks6502);
+  put32(header + 21, m->clock_start);
+  put32(header + 25, m->timerPeriod);
+  put32(header + 29, m->timerNext);
+  header[33] = m->timerControl;
+  header[34] = m->timerPending ? 1 : 0;
+
+  FILE *file = fopen(filename, "wb");
+  if (!file) {
+    fprintf(stderr, "Could not open '%s': ", filename);
+    perror(NULL);
+    return false;
+  }
+  if (fwrite(header, sizeof(header), 1, file) != 1 ||
+      fwrite(m->memory, sizeof(m->memory), 1, file) != 1 || fclose(file)) {
+    fprintf(stderr, "Error writing state file '%s': ", filename);
+    perror(NULL);
+    return false;
+  }
+  return true;
+}
+
+bool loadState(struct machine *m, const char *filename) {
+  FILE *file = fopen(filename, "rb");
+  if (!file) {
+    fprintf(stderr, "Could not open '%s': ", filename);
+    perror(NULL);
+    return false;
+  }
+  uint8_t header[STATE_HEADER_SIZE];
+  if (fread(header, sizeof(header), 1, file) != 1 ||
+      fread(m->memory, sizeof(m->memory), 1, file) != 1) {
+    fprintf(stderr, "Error reading state file '%s': ", filename);
+    if (feof(file))
+      fputs("unexpected EOF.\n", stderr);
+    else
+      perror(NULL);
+    fclose(file);
+    return false;
+  }
+  fclose(file);
+  if (memcmp(header, stateMagic, sizeof(stateMagic)) ||
+      header[8] != stateVersion) {
+    fprintf(stderr, "'%s' is not a compatible state file.\n", filename);
+    return false;
+  }
+
+  struct cpu6502 *c = &m->cpu;
+  cmos = header[9] & 1;
+  m->input_eof = header[9] & 2;
+  // Select the instruction tables; the registers are overwritten below.
+  reset6502(c, cmos);
+  c->pc = get16(header + 10);
+  c->a = header[12];
+  c->x = header[13];
+  c->y = header[14];
+  c->sp = header[15];
+  c->status = header[16];
+  c->clockticks6502 = get32(header + 17);
+  m->clock_start = get32(header + 21);
+  m->timerPeriod = get32(header + 25);
+  m->timerNext = get32(header + 29);
+  m->timerControl = header[33];
+  m->timerPending = header[34] & 1;
+  return true;
+}
+
+// Loads an ELF executable, or an image in the block format described in the
+// usage text.
+bool loadImage(struct machine *m, const char *filename) {
+  struct mappedFile f;
+  if (!mapFile(filename, &f))
+    return false;
+  if (isElf(&f)) {
+    bool ok = loadElfSegments(&f, filename, m->memory);
+    unmapFile(&f);
+    return ok;
+  }
+
+  bool ok = false;
+  // A trailing partial address is ignored.
+  for (size_t pos = 0; f.size - pos >= 2;) {
+    if (f.size - pos < 4) {
+      fprintf(stderr, "Error reading image file '%s': expected block size, "
+                      "found EOF.\n",
+              filename);
+      goto done;
+    }
+    uint16_t address = f.data[pos] | f.data[pos + 1] << 8;
+    uint16_t size = f.data[pos + 2] | f.data[pos + 3] << 8;
+    pos += 4;
+
+    uint32_t lastAddress = address + size - 1;
+    if (lastAddress >= 65536) {
+      fprintf(stderr,
+              "Invalid block: block of %d bytes at address %d would reach "
+              "location %d, which is out of bounds.\n",
+              size, address, lastAddress);
+      goto done;
+    }
+
+    if (f.size - pos < size) {
+      fprintf(stderr,
+              "Error reading image file '%s': expected %d byte block, found "
+              "%zu bytes.\n",
+              filename, size, f.size - pos);
+      goto done;
+    }
+    memcpy(&m->memory[address], f.data + pos, size);
+    pos += size;
+  }
+  ok = true;
+
+done:
+  unmapFile(&f);
+  return ok;
+}
+
+// One image of a batch run and its results.
+struct job {
+  char *image;
+  bool loaded;
+  enum machineState state;
+  uint8_t exitCode;
+  uint32_t cycles;
+  struct buffer output;
+};
+
+struct batch {
+  struct job *jobs;
+  size_t numJobs, capacity;
+  size_t nextJob;
+  pthread_mutex_t lock;
+};
+
+static void addJob(struct batch *b, const char *image) {
+  if (b->numJobs == b->capacity) {
+    b->capacity = b->capacity ? b->capacity * 2 : 64;
+    b->jobs = realloc(b->jobs, b->capacity * sizeof(struct job));
+    if (!b->jobs) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  struct job *j = &b->jobs[b->numJobs++];
+  memset(j, 0, sizeof(*j));
+  j->image = strdup(image);
+}
+
+static int compareJobs(const void *a, const void *b) {
+  return strcmp(((const struct job *)a)->image, ((const struct job *)b)->image);
+}
+
+// Collects every regular file in a directory (in name order) or every line
+// of a manifest file. Either may be an ELF executable or an image file.
+// Blank lines and lines starting with '#' are skipped.
+bool collectJobs(struct batch *b, const char *path) {
+  struct stat st;
+  if (stat(path, &st)) {
+    fprintf(stderr, "Could not open '%s': ", path);
+    perror(NULL);
+    return false;
+  }
+
+  if (S_ISDIR(st.st_mode)) {
+    DIR *dir = opendir(path);
+    if (!dir) {
+      fprintf(stderr, "Could not open '%s': ", path);
+      perror(NULL);
+      return false;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+      const char *name = entry->d_name;
+      size_t len = strlen(name);
+      char *image = malloc(strlen(path) + len + 2);
+      if (!image) {
+        perror("malloc");
+        exit(1);
+      }
+      sprintf(image, "%s/%s", path, name);
+      if (!stat(image, &st) && S_ISREG(st.st_mode)) {
+        // An ELF file is run on its own, but the SDK also builds an image
+        // from each one; only run the image then.
+        bool duplicate = false;
+        if (len > 4 && !strcmp(name + len - 4, ".elf")) {
+          char *dot = image + strlen(image) - 4;
+          *dot = '\0';
+          duplicate = !stat(image, &st) && S_ISREG(st.st_mode);
+          *dot = '.';
+        }
+        if (!duplicate)
+          addJob(b, image);
+      }
+      free(image);
+    }
+    closedir(dir);
+    qsort(b->jobs, b->numJobs, sizeof(struct job), compareJobs);
+    return true;
+  }
+
+  FILE *manifest = fopen(path, "r");
+  if (!manifest) {
+    fprintf(stderr, "Could not open '%s': ", path);
+    perror(NULL);
+    return false;
+  }
+  char line[4096];
+  while (fgets(line, sizeof(line), manifest)) {
+    size_t len = strcspn(line, "\r\n");
+    line[len] = '\0';
+    if (!len || line[0] == '#')
+      continue;
+    addJob(b, line);
+  }
+  fclose(manifest);
+  return true;
+}
+
+void runJob(struct job *j) {
+  struct machine *m = newMachine();
+  m->output = &j->output;
+  j->loaded = loadImage(m, j->image);
+  if (j->loaded) {
+    reset6502(&m->cpu, cmos);
+    for (;;) {
+      run(m);
+      // Snapshots have no meaning in batch mode.
+      if (m->state != SNAPSHOT_REQUESTED)
+        break;
+      m->state = RUNNING;
+    }
+    j->state = m->state;
+    j->exitCode = m->exitCode;
+    j->cycles = m->cpu.clockticks6502;
+  }
+  freeMachine(m);
+}
+
+static void *batchWorker(void *arg) {
+  struct batch *b = arg;
+  for (;;) {
+    pthread_mutex_lock(&b->lock);
+    size_t i = b->nextJob++;
+    pthread_mutex_unlock(&b->lock);
+    if (i >= b->numJobs)
+      return NULL;
+    runJob(&b->jobs[i]);
+  }
 }
 
+// Runs every image of the batch across a pool of threads, then reports the
+// results in order. Returns the process exit code.
+int runBatch(const char *path) {
+  struct batch b;
+  memset(&b, 0, sizeof(b));
+  if (!collectJobs(&b, path))
+    return 1;
+  pthread_mutex_init(&b.lock, NULL);
+
+  if (jobs <= 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+    jobs = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (jobs <= 0)
+      jobs = 1;
+  }
+  if ((size_t)jobs > b.numJobs)
+    jobs = b.numJobs ? b.numJobs : 1;
+
+  pthread_t *threads = malloc(jobs * sizeof(pthread_t));
+  if (!threads) {
+    perror("malloc");
+    exit(1);
+  }
+  int numThreads = 0;
+  for (; numThreads < jobs; ++numThreads)
+    if (pthread_create(&threads[numThreads], NULL, batchWorker, &b))
+      break;
+  if (!numThreads)
+    batchWorker(&b);
+  for (int i = 0; i < numThreads; ++i)
+    pthread_join(threads[i], NULL);
+  free(threads);
+  pthread_mutex_destroy(&b.lock);
+
+  // Each result is a header line followed by exactly as many bytes of output
+  // as it announces, terminated by a newline.
+  size_t failures = 0;
+  for (size_t i = 0; i < b.numJobs; ++i) {
+    struct job *j = &b.jobs[i];
+    printf("== %s: ", j->image);
+    if (!j->loaded) {
+      printf("load failed\n");
+      ++failures;
+      continue;
+    }
+    if (j->state == ABORTED)
+      printf("aborted");
+    else
+      printf("exit %d", j->exitCode);
+    printf(", %u cycles, %zu bytes of output\n", j->cycles, j->output.size);
+    fwrite(j->output.data, 1, j->output.size, stdout);
+    if (j->output.size)
+      putchar('\n');
+    if (j->state == ABORTED || j->exitCode)
+      ++failures;
+    free(j->output.data);
+    free(j->image);
+  }
+  free(b.jobs);
+  fprintf(stderr, "%zu images, %zu failed\n", b.numJobs, failures);
+  return failures ? 1 : 0;
+}
+
+static unsigned long parseNumber(const char *arg, int base, unsigned long max,
+                                 const char *what) {
+  char *end;
+  unsigned long value = strtoul(arg, &end, base);
+  if (!*arg || *end || value > max) {
+    fprintf(stderr, "Invalid %s '%s'.\n", what, arg);
+    exit(1);
+  }
+  return value;
+}
+
+// Flags that take an argument.
+static const char *const argumentFlags[] = {
+    "--save-state", "--load-state", "--save-state-on-write",
+    "--batch",      "--jobs",       "--trace-file",
+    "--gdb",        "--symbols",    "--memory-report",
+    "--hle-cycles", NULL,
+};
+
 bool parseFlag(int *argc, const char ***argv) {
   if (*argc < 2)
     return false;
   const char *flag = (*argv)[1];
+  const char *arg = NULL;
+  int consumed = 1;
+  for (const char *const *f = argumentFlags; *f; ++f) {
+    if (strcmp(flag, *f))
+      continue;
+    if (*argc < 3) {
+      fprintf(stderr, "Missing argument to %s.\n", flag);
+      exit(1);
+    }
+    arg = (*argv)[2];
+    consumed = 2;
+  }
+
   if (!strcmp(flag, "--cycles")) {
     shouldPrintCycles = true;
   } else if (!strcmp(flag, "--trace")) {
     shouldTrace = true;
+  } else if (!strcmp(flag, "--trace-file")) {
+    traceFile = arg;
+  } else if (!strcmp(flag, "--symbols")) {
+    symbolsFile = arg;
+  } else if (!strcmp(flag, "--memory-report")) {
+    memoryReportFile = arg;
   } else if (!strcmp(flag, "--profile")) {
     shouldProfile = true;
   } else if (!strcmp(flag, "--cmos")) {
     cmos = true;
+  } else if (!strcmp(flag, "--save-state")) {
+    saveStateFile = arg;
+  } else if (!strcmp(flag, "--save-state-on-write")) {
+    saveStateAddress = parseNumber(arg, 16, 0xffff, "address");
+  } else if (!strcmp(flag, "--load-state")) {
+    loadStateFile = arg;
+  } else if (!strcmp(flag, "--hle")) {
+    hle = true;
+  } else if (!strcmp(flag, "--hle-cycles")) {
+    hleCycles = parseNumber(arg, 10, UINT32_MAX, "cycle count");
+  } else if (!strcmp(flag, "--gdb")) {
+    gdbPort = parseNumber(arg, 10, 65535, "port");
+  } else if (!strcmp(flag, "--batch")) {
+    batchPath = arg;
+  } else if (!strcmp(flag, "--jobs")) {
+    jobs = parseNumber(arg, 10, 4096, "job count");
+    if (!jobs) {
+      fprintf(stderr, "Invalid job count '%s'.\n", arg);
+      exit(1);
+    }
   } else
     return false;
 
-  for (int i = 2; i < *argc; ++i) {
-    (*argv)[i - 1] = (*argv)[i];
+  for (int i = 1 + consumed; i < *argc; ++i) {
+    (*argv)[i - consumed] = (*argv)[i];
   }
-  --*argc;
+  *argc -= consumed;
   return true;
 }
 
-
 int main(int argc, const char *argv[]) {
   while (parseFlag(&argc, &argv));
 
-  if (argc < 2) {
-    fputs(usage, stderr);
-    return 1;
+  if (batchPath) {
+    if (argc > 1 || shouldTrace || traceFile || shouldProfile || saveStateFile ||
+        loadStateFile || gdbPort || memoryReportFile || hle) {
+      fputs(usage, stderr);
+      return 1;
+    }
+    return runBatch(batchPath);
   }
-  const char *filename = argv[1];
 
-  FILE *file = fopen(filename, "rb");
-  if (!file) {
-    fprintf(stderr, "Could not open '%s': ", filename);
-    perror(NULL);
+  // An ELF image brings its own symbols.
+  if (!symbolsFile && !loadStateFile && argc > 1 && isElfFile(argv[1]))
+    symbolsFile = argv[1];
+  if (symbolsFile && !loadSymbols(&symbols, symbolsFile, NULL))
+    return 1;
+  if (hle && !symbolsFile) {
+    fputs("--hle needs symbols to find the routines.\n", stderr);
     return 1;
   }
 
-  while (1) {
-    // Assumes host is little-endian.
-    uint16_t address;
-    if (fread(&address, 2, 1, file) != 1) {
-      if (feof(file))
-        break;
-      else {
-        fprintf(stderr, "Error reading image file '%s': ", filename);
-        perror(NULL);
-        return 1;
-      }
-    }
-
-    uint16_t size;
-    if (fread(&size, 2, 1, file) != 1) {
-      fprintf(stderr, "Error reading image file '%s': ", filename);
-      if (feof(file))
-        fputs("expected block size, found EOF.", stderr);
-      else
-        perror(NULL);
+  struct machine *m = newMachine();
+  m->input = stdin;
+  if (loadStateFile) {
+    if (argc > 1) {
+      fputs(usage, stderr);
       return 1;
     }
-
-    uint32_t lastAddress = address + size - 1;
-    if (lastAddress >= 65536) {
-      fprintf(stderr,
-              "Invalid block: block of %d bytes at address %d would reach "
-              "location %d, which is out of bounds.\n",
-              size, address, lastAddress);
+    if (!loadState(m, loadStateFile))
       return 1;
-    }
-
-    size_t readSize = fread(&memory[address], 1, size, file);
-    if (readSize != size) {
-      fprintf(stderr, "Error reading image file '%s': ", filename);
-      if (feof(file)) {
-        fprintf(stderr, "expected %d byte block, found %zu bytes.", size,
-                readSize);
-      } else
-        perror(NULL);
+  } else {
+    if (argc < 2) {
+      fputs(usage, stderr);
       return 1;
     }
+    if (!loadImage(m, argv[1]))
+      return 1;
+    reset6502(&m->cpu, cmos);
   }
+  if (traceFile)
+    m->trace = traceOpen(traceFile, m->cpu.clockticks6502);
+  if (gdbPort && !gdbServe(m, gdbPort))
+    return 1;
 
-  reset6502(cmos);
   for (;;) {
-    if (shouldTrace)
-      fprintf(stderr, "%04x a:%02x x:%02x y:%02x s: %02x st:%02x\n", pc, a, x, y, sp, status);
-    uint32_t clockTicksBefore = clockticks6502;
-    uint16_t addr = pc;
-    step6502();
-    clockTicksAtAddress[addr] += clockticks6502 - clockTicksBefore;
-  }
-  finish();
-  return 0;
+    run(m);
+    if (m->state != SNAPSHOT_REQUESTED)
+      break;
+    if (saveStateFile) {
+      if (!saveState(m, saveStateFile))
+        return 1;
+      finish(m);
+      return 0;
+    }
+    m->state = RUNNING;
+  }
+
+  finish(m);
+  if (m->state == ABORTED)
+    abort();
+  return m->exitCode;
 }
@@ -0,0 +1,109 @@
+#ifndef _MOS_SIM_H_
+#define _MOS_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "fake6502.h"
+
+// A growable byte buffer, used to capture the output of batch runs.
+struct buffer {
+  char *data;
+  size_t size, capacity;
+};
+
+enum machineState {
+  RUNNING,
+  SNAPSHOT_REQUESTED,
+  // A watchpoint triggered; the debugger takes over.
+  WATCHPOINT_HIT,
+  EXITED,
+  ABORTED,
+};
+
+// Timer control register ($FFE4) bits.
+#define TIMER_ENABLE 1
+#define TIMER_NMI 2
+#define TIMER_ONE_SHOT 4
+
+// Watchpoint kinds, as a mask per watched address.
+#define WATCH_READ 1
+#define WATCH_WRITE 2
+
+struct hle;
+struct memoryStats;
+struct symbolTable;
+struct traceWriter;
+
+// A complete simulated machine: the CPU, its memory, and the I/O devices.
+struct machine {
+  struct cpu6502 cpu;
+  uint8_t memory[65536];
+  uint32_t clock_start;
+  bool input_eof;
+  // Source of $FFF5 reads; NULL reads as EOF.
+  FILE *input;
+  // Destination of $FFF9 writes; NULL writes to stdout.
+  struct buffer *output;
+  // Cycles spent at each PC address; only allocated with --profile.
+  uint32_t *clockTicksAtAddress;
+  // Binary trace destination; only opened with --trace-file.
+  struct traceWriter *trace;
+  // Access counts; only allocated with --memory-report. All memory accesses
+  // go through the I/O callbacks while this is set.
+  struct memoryStats *stats;
+  // Routines to emulate on the host; only allocated with --hle.
+  struct hle *hle;
+  enum machineState state;
+  uint8_t exitCode;
+  // Cycle count at the write that exited or aborted.
+  uint32_t haltClockticks;
+
+  // Programmable timer. It fires when the cycle count reaches timerNext,
+  // then every timerPeriod cycles after that unless it is one-shot.
+  uint32_t timerPeriod, timerNext;
+  uint8_t timerControl;
+  // Set when the timer fires; cleared by a write to the status register.
+  // Holds the IRQ line low until then.
+  bool timerPending;
+
+  // Debugger watchpoints: a WATCH_* mask per address, allocated when the
+  // first one is set. Pages with any watched address are left out of the
+  // CPU's memory map, so unwatched pages pay nothing.
+  uint8_t *watchpoints;
+  uint16_t readWatches[256], writeWatches[256];
+  // The access that caused WATCHPOINT_HIT.
+  uint16_t watchAddress;
+  uint8_t watchKind;
+};
+
+// Executes one instruction, with tracing and profiling as configured.
+void stepMachine(struct machine *m);
+
+// Recomputes whether a page can be accessed directly through the CPU's
+// memory map, or must go through the I/O callbacks.
+void mapPage(struct machine *m, uint8_t page);
+
+// Memory access statistics (memory-report.c).
+struct memoryStats *newMemoryStats(const struct symbolTable *symbols);
+void noteRead(struct machine *m, uint16_t address);
+void noteWrite(struct machine *m, uint16_t address);
+void noteInstruction(struct machine *m);
+bool writeMemoryReport(const struct machine *m,
+                       const struct symbolTable *symbols,
+                       const char *filename);
+
+// High-level emulation of runtime routines (hle.c). Each emulated call costs
+// the given number of cycles, including its return.
+struct hle *newHle(const struct symbolTable *symbols, uint32_t cycles);
+// If the PC is at the entry of a known routine, performs the whole call and
+// returns true.
+bool emulateRoutine(struct machine *m);
+
+// Serves the GDB remote protocol on a local TCP port until the program
+// exits, or the debugger kills or detaches from it. Returns false if the
+// connection could not be established.
+bool gdbServe(struct machine *m, unsigned port);
+
+#endif // _MOS_SIM_H_
@@ -0,0 +1,143 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim-trace.h"
+#include "symbols.h"
+
+static const char usage[] =
+    "Usage: mos-trace [OPTIONS] trace\n"
+    "\n"
+    "Converts a binary trace written by mos-sim --trace-file to text.\n"
+    "\n"
+    "Each instruction is printed as its starting cycle count, followed by\n"
+    "the registers before it executed.\n"
+    "\n"
+    "OPTIONS:\n"
+    "\t--symbols FILE: Annotate each PC with the nearest preceding text\n"
+    "\t\tsymbol, read from an ELF file or from FILE in the format\n"
+    "\t\tproduced by llvm-nm.\n"
+    "\t--range LO-HI: Only print instructions with LO <= PC <= HI\n"
+    "\t\t(hexadecimal).\n"
+    "\t--cycles FROM-TO: Only print instructions starting in the given\n"
+    "\t\tcycle range (decimal).\n"
+    "\t--limit N: Stop after printing N instructions.\n";
+
+static struct symbolTable symbols;
+
+static bool parseRange(const char *arg, int base, unsigned long *lo,
+                       unsigned long *hi) {
+  char *end;
+  *lo = strtoul(arg, &end, base);
+  if (end == arg || *end != '-')
+    return false;
+  const char *rest = end + 1;
+  *hi = strtoul(rest, &end, base);
+  return end != rest && !*end && *lo <= *hi;
+}
+
+int main(int argc, const char *argv[]) {
+  const char *symbolsFile = NULL;
+  unsigned long pcLo = 0, pcHi = 0xffff;
+  unsigned long cycleLo = 0, cycleHi = UINT32_MAX;
+  unsigned long limit = 0;
+  const char *filename = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    const char *flag = argv[i];
+    if (flag[0] != '-') {
+      if (filename) {
+        fputs(usage, stderr);
+        return 1;
+      }
+      filename = flag;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      fputs(usage, stderr);
+      return 1;
+    }
+    const char *arg = argv[++i];
+    bool ok = true;
+    if (!strcmp(flag, "--symbols"))
+      symbolsFile = arg;
+    else if (!strcmp(flag, "--range"))
+      ok = parseRange(arg, 16, &pcLo, &pcHi);
+    else if (!strcmp(flag, "--cycles"))
+      ok = parseRange(arg, 10, &cycleLo, &cycleHi);
+    else if (!strcmp(flag, "--limit")) {
+      char *end;
+      limit = strtoul(arg, &end, 10);
+      ok = *arg && !*end;
+    } else
+      ok = false;
+    if (!ok) {
+      fputs(usage, stderr);
+      return 1;
+    }
+  }
+  if (!filename) {
+    fputs(usage, stderr);
+    return 1;
+  }
+  if (symbolsFile && !loadSymbols(&symbols, symbolsFile, "tTwW"))
+    return 1;
+
+  FILE *file = fopen(filename, "rb");
+  if (!file) {
+    fprintf(stderr, "Could not open '%s': ", filename);
+    perror(NULL);
+    return 1;
+  }
+  setvbuf(file, NULL, _IOFBF, 1 << 20);
+  setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+
+  uint8_t header[TRACE_HEADER_SIZE];
+  if (fread(header, sizeof(header), 1, file) != 1 ||
+      memcmp(header, TRACE_MAGIC, 8) || header[8] != TRACE_VERSION ||
+      header[9] != TRACE_RECORD_SIZE) {
+    fprintf(stderr, "'%s' is not a compatible trace file.\n", filename);
+    return 1;
+  }
+  uint32_t cycles = header[12] | header[13] << 8 | header[14] << 16 |
+                    (uint32_t)header[15] << 24;
+
+  unsigned long printed = 0;
+  uint8_t r[TRACE_RECORD_SIZE];
+  while (fread(r, sizeof(r), 1, file) == 1) {
+    uint16_t pc = r[0] | r[1] << 8;
+    uint32_t delta = r[7];
+    if (delta == TRACE_DELTA_EXTENDED) {
+      uint8_t ext[TRACE_RECORD_SIZE];
+      if (fread(ext, sizeof(ext), 1, file) != 1)
+        break;
+      delta = ext[0] | ext[1] << 8 | ext[2] << 16 | (uint32_t)ext[3] << 24;
+    }
+
+    if (pc >= pcLo && pc <= pcHi && cycles >= cycleLo && cycles <= cycleHi) {
+      printf("%10u %04x a:%02x x:%02x y:%02x s: %02x st:%02x", cycles, pc,
+             r[2], r[3], r[4], r[5], r[6]);
+      const struct symbol *sym = findSymbol(&symbols, pc);
+      if (sym) {
+        if (pc == sym->address)
+          printf(" %s", sym->name);
+        else
+          printf(" %s+%u", sym->name, pc - sym->address);
+      }
+      putchar('\n');
+      if (limit && ++printed == limit)
+        break;
+    }
+    cycles += delta;
+  }
+
+  if (ferror(file)) {
+    fprintf(stderr, "Error reading trace file '%s': ", filename);
+    perror(NULL);
+    return 1;
+  }
+  fclose(file);
+  return 0;
+}
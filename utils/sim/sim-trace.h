@@ -0,0 +1,32 @@
+#ifndef _SIM_TRACE_H_
+#define _SIM_TRACE_H_
+
+// Binary instruction trace written by mos-sim --trace-file and read by
+// mos-trace.
+//
+// The file starts with a 16-byte header:
+//   0: Magic "MOSTRACE"
+//   8: Version (1 byte)
+//   9: Record size (1 byte)
+//  10: Reserved (2 bytes)
+//  12: Cycle count before the first traced instruction (4 bytes)
+//
+// Then one 8-byte record per instruction, holding the registers before the
+// instruction executed and the cycles it took:
+//   0: pc (2 bytes)
+//   2: a, x, y, sp, status (1 byte each)
+//   7: Cycle delta (1 byte)
+//
+// A cycle delta of TRACE_DELTA_EXTENDED means the record is followed by an
+// extension record whose first 4 bytes hold the full delta; its remaining
+// bytes are zero.
+//
+// All multi-byte values are little-endian.
+
+#define TRACE_MAGIC "MOSTRACE"
+#define TRACE_VERSION 1
+#define TRACE_HEADER_SIZE 16
+#define TRACE_RECORD_SIZE 8
+#define TRACE_DELTA_EXTENDED 0xff
+
+#endif // _SIM_TRACE_H_
@@ -0,0 +1,103 @@
+#include "symbols.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "elf.h"
+
+void addSymbol(struct symbolTable *t, uint32_t address, uint32_t size,
+               char type, const char *name) {
+  if (t->count == t->capacity) {
+    t->capacity = t->capacity ? t->capacity * 2 : 256;
+    t->symbols = realloc(t->symbols, t->capacity * sizeof(struct symbol));
+    if (!t->symbols) {
+      perror("realloc");
+      exit(1);
+    }
+  }
+  struct symbol *s = &t->symbols[t->count++];
+  s->address = address;
+  s->size = size;
+  s->type = type;
+  s->name = strdup(name);
+}
+
+static int compareSymbols(const void *a, const void *b) {
+  uint32_t x = ((const struct symbol *)a)->address;
+  uint32_t y = ((const struct symbol *)b)->address;
+  return x < y ? -1 : x > y;
+}
+
+void sortSymbols(struct symbolTable *t) {
+  qsort(t->symbols, t->count, sizeof(struct symbol), compareSymbols);
+}
+
+bool loadNmSymbols(struct symbolTable *t, const char *filename,
+                   const char *types) {
+  FILE *file = fopen(filename, "r");
+  if (!file) {
+    fprintf(stderr, "Could not open '%s': ", filename);
+    perror(NULL);
+    return false;
+  }
+  char line[1024];
+  while (fgets(line, sizeof(line), file)) {
+    // Either "address type name" or, with -S, "address size type name".
+    // Undefined symbols have no address and are skipped.
+    char *fields[4];
+    int n = 0;
+    for (char *f = strtok(line, " \t\r\n"); f && n < 4;
+         f = strtok(NULL, " \t\r\n"))
+      fields[n++] = f;
+    if (n < 3 || strlen(fields[n - 2]) != 1)
+      continue;
+    char *end;
+    unsigned long address = strtoul(fields[0], &end, 16);
+    if (*end)
+      continue;
+    unsigned long size = n == 4 ? strtoul(fields[1], NULL, 16) : 0;
+    char type = fields[n - 2][0];
+    const char *name = fields[n - 1];
+    if (types && !strchr(types, type))
+      continue;
+    addSymbol(t, address, size, type, name);
+  }
+  fclose(file);
+  sortSymbols(t);
+  return true;
+}
+
+bool loadSymbols(struct symbolTable *t, const char *filename,
+                 const char *types) {
+  if (!isElfFile(filename))
+    return loadNmSymbols(t, filename, types);
+  struct mappedFile f;
+  if (!mapFile(filename, &f))
+    return false;
+  bool ok = loadElfSymbols(t, &f, filename, types);
+  unmapFile(&f);
+  sortSymbols(t);
+  return ok;
+}
+
+const struct symbol *findSymbol(const struct symbolTable *t,
+                                uint32_t address) {
+  size_t lo = 0, hi = t->count;
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (t->symbols[mid].address <= address)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo ? &t->symbols[lo - 1] : NULL;
+}
+
+const struct symbol *lookupSymbol(const struct symbolTable *t,
+                                  const char *name) {
+  for (size_t i = 0; i < t->count; ++i)
+    if (!strcmp(t->symbols[i].name, name))
+      return &t->symbols[i];
+  return NULL;
+}
@@ -0,0 +1,46 @@
+#ifndef _SYMBOLS_H_
+#define _SYMBOLS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct symbol {
+  uint32_t address;
+  // Zero if unknown.
+  uint32_t size;
+  char type;
+  char *name;
+};
+
+// A set of symbols sorted by address.
+struct symbolTable {
+  struct symbol *symbols;
+  size_t count, capacity;
+};
+
+// Adds the symbols listed in FILE in the format produced by llvm-nm (with or
+// without -S). Only symbols whose nm type letter appears in types are kept;
+// NULL keeps all defined symbols.
+bool loadNmSymbols(struct symbolTable *t, const char *filename,
+                   const char *types);
+
+// Adds the symbols from FILE, which is either an ELF file or the output of
+// llvm-nm as above.
+bool loadSymbols(struct symbolTable *t, const char *filename,
+                 const char *types);
+
+// Adds one symbol. The table must be re-sorted with sortSymbols afterwards.
+void addSymbol(struct symbolTable *t, uint32_t address, uint32_t size,
+               char type, const char *name);
+void sortSymbols(struct symbolTable *t);
+
+// Returns the nearest symbol at or below the address, or NULL.
+const struct symbol *findSymbol(const struct symbolTable *t,
+                                uint32_t address);
+
+// Returns the symbol with the given name, or NULL.
+const struct symbol *lookupSymbol(const struct symbolTable *t,
+                                  const char *name);
+
+#endif // _SYMBOLS_H_